@@ -0,0 +1,115 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+// a 64 bytes row, a scan of key only needs 8 bytes of it
+typedef struct Row
+{
+    uint64_t key;
+    uint64_t payload[7];
+} Row;
+
+// usage: benchColumnScan [count], the default is 10M rows
+int main(int argc, char **argv)
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    size_t count = 10000000;
+    if (argc > 1)
+    {
+        count = (size_t)strtoull(argv[1], NULL, 10);
+    }
+
+    size_t sizes[2] = {sizeof(uint64_t), sizeof(uint64_t) * 7};
+    size_t offsets[2] = {offsetof(Row, key), offsetof(Row, payload)};
+    fdsa_vector *rows = api.vector.create(sizeof(Row));
+    fdsa_columnVector *columns = api.columnVector.create(2, sizes, offsets);
+    if (!rows || !columns ||
+        api.vector.reserve(rows, count) == fdsa_failed ||
+        api.columnVector.reserve(columns, count) == fdsa_failed)
+    {
+        fputs("Fail to allocate memory.\n", stderr);
+        return 1;
+    }
+
+    uint64_t state = 88172645463325252ULL;
+    Row row = {0};
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        row.key = state;
+        row.payload[0] = i;
+        api.vector.pushBack(rows, &row);
+        api.columnVector.pushBack(columns, &row);
+    }
+
+    printf("rows: %zu\n", count);
+
+    // row layout, every key drags a whole cache line in
+    const Row *rowData = api.vector.data(rows);
+    uint64_t rowSum = 0;
+    uint64_t start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        rowSum += rowData[i].key;
+    }
+
+    printf("row layout: %.3f ms\n",
+           (double)(benchNow() - start) / 1000000.0);
+
+    // column layout, keys are packed 8 per cache line
+    const uint64_t *keys = api.columnVector.columnData(columns, 0);
+    uint64_t columnSum = 0;
+    start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        columnSum += keys[i];
+    }
+
+    printf("column layout: %.3f ms\n",
+           (double)(benchNow() - start) / 1000000.0);
+
+    if (rowSum != columnSum)
+    {
+        fputs("Result mismatch.\n", stderr);
+        return 1;
+    }
+
+    api.columnVector.destory(columns);
+    return (api.vector.destory(rows) == fdsa_failed);
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+typedef struct Sample
+{
+    uint64_t timestamp;
+    uint64_t value;
+} Sample;
+
+static const size_t totalSamples = 1 << 23;
+
+template<typename Producer>
+static double runProducers(unsigned threads, Producer producer)
+{
+    std::vector<std::thread> workers;
+    uint64_t start = benchNow();
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([=]()
+        {
+            Sample sample = {i, 0};
+            size_t count = totalSamples / threads;
+            for (size_t j = 0; j < count; ++j)
+            {
+                sample.value = j;
+                producer(&sample);
+            }
+        });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    return static_cast<double>(benchNow() - start) / 1000000.0;
+}
+
+int main(int argc, char **argv)
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    unsigned maxThreads = std::thread::hardware_concurrency();
+    if (argc > 1)
+    {
+        maxThreads = static_cast<unsigned>(atoi(argv[1]));
+    }
+
+    if (!maxThreads) maxThreads = 1;
+
+    puts("threads, mutex pushBack (ms), concurrent pushBack (ms)");
+    for (unsigned threads = 1; threads <= maxThreads; threads <<= 1)
+    {
+        fdsa_vector *vec = api.vector.create(sizeof(Sample));
+        fdsa_concurrentVector *cvec =
+            api.concurrentVector.create(sizeof(Sample));
+        if (!vec || !cvec)
+        {
+            fputs("Fail to create vector.\n", stderr);
+            return 1;
+        }
+
+        double mutexTime = runProducers(threads, [&](const Sample *sample)
+        {
+            api.vector.pushBack(vec, sample);
+        });
+
+        double concurrentTime = runProducers(threads,
+                                             [&](const Sample *sample)
+        {
+            api.concurrentVector.pushBack(cvec, sample);
+        });
+
+        size_t size = 0, csize = 0;
+        api.vector.size(vec, &size);
+        api.concurrentVector.size(cvec, &csize);
+        if (size != csize)
+        {
+            fputs("Size mismatch.\n", stderr);
+            return 1;
+        }
+
+        printf("%u, %.3f, %.3f\n", threads, mutexTime, concurrentTime);
+        api.vector.destory(vec);
+        api.concurrentVector.destory(cvec);
+    }
+
+    return 0;
+}
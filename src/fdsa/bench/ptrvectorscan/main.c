@@ -0,0 +1,132 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+typedef struct Object
+{
+    uint64_t key;
+    uint64_t payload[7];
+} Object;
+
+static int sumObject(void *element, size_t index, void *ctx)
+{
+    (void)index;
+    *(uint64_t *)ctx += ((Object *)element)->key;
+    return 0;
+}
+
+// usage: benchPtrVectorScan [count], the default is 10M objects
+int main(int argc, char **argv)
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    size_t count = 10000000;
+    if (argc > 1)
+    {
+        count = (size_t)strtoull(argv[1], NULL, 10);
+    }
+
+    void **objects = malloc(count * sizeof(void *));
+    fdsa_ptrVector *vec = api.ptrVector.create(free);
+    if (!objects || !vec)
+    {
+        fputs("Fail to allocate memory.\n", stderr);
+        return 1;
+    }
+
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        Object *object = calloc(1, sizeof(Object));
+        if (!object)
+        {
+            fputs("Fail to allocate memory.\n", stderr);
+            return 1;
+        }
+
+        object->key = i;
+        objects[i] = object;
+    }
+
+    // shuffle, so that the pointees are scattered like a long-lived heap
+    uint64_t state = 88172645463325252ULL;
+    for (i = count; i > 1; --i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t j = (size_t)(state % i);
+        void *tmp = objects[i - 1];
+        objects[i - 1] = objects[j];
+        objects[j] = tmp;
+    }
+
+    if (api.ptrVector.pushBackN(vec, objects, count) == fdsa_failed)
+    {
+        fputs("Fail to pushback.\n", stderr);
+        return 1;
+    }
+
+    printf("objects: %zu\n", count);
+
+    // one lock per element
+    uint64_t expected = 0;
+    uint64_t start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        expected += ((Object *)api.ptrVector.at(vec, i))->key;
+    }
+
+    printf("fdsa_ptrVector_at: %.3f ms\n",
+           (double)(benchNow() - start) / 1000000.0);
+
+    size_t distances[3] = {0, 8, 16};
+    for (i = 0; i < 3; ++i)
+    {
+        uint64_t sum = 0;
+        start = benchNow();
+        api.ptrVector.forEach(vec, sumObject, &sum, distances[i]);
+        printf("fdsa_ptrVector_forEach, prefetch %zu: %.3f ms\n",
+               distances[i], (double)(benchNow() - start) / 1000000.0);
+
+        if (sum != expected)
+        {
+            fputs("Result mismatch.\n", stderr);
+            return 1;
+        }
+    }
+
+    free(objects);
+    return (api.ptrVector.destory(vec) == fdsa_failed);
+}
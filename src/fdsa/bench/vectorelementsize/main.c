@@ -0,0 +1,101 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+// Per-element throughput of pushBack, at and setValue for each element
+// width. 12 and 24 bytes take the generic memcpy path.
+static int benchWidth(fdsa_vector_api *vecApi, size_t width)
+{
+    const size_t count = 1 << 22;
+    uint8_t element[32];
+    memset(element, 0x5a, sizeof(element));
+
+    fdsa_vector *vec = vecApi->createEx(width, fdsa_vector_lockNone);
+    if (!vec || vecApi->reserve(vec, count) == fdsa_failed)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        if (vec) vecApi->destory(vec);
+        return 1;
+    }
+
+    size_t i;
+    uint64_t start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        vecApi->pushBack(vec, element);
+    }
+
+    uint64_t pushBackTime = benchNow() - start;
+
+    start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        vecApi->at(vec, i, element);
+    }
+
+    uint64_t atTime = benchNow() - start;
+
+    start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        vecApi->setValue(vec, i, element);
+    }
+
+    uint64_t setValueTime = benchNow() - start;
+
+    printf("%zu, %.2f, %.2f, %.2f\n", width,
+           (double)pushBackTime / (double)count,
+           (double)atTime / (double)count,
+           (double)setValueTime / (double)count);
+    return (vecApi->destory(vec) == fdsa_failed);
+}
+
+int main()
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    const size_t widths[] = {1, 2, 4, 8, 12, 16, 24, 32};
+    size_t i;
+
+    puts("width, pushBack (ns), at (ns), setValue (ns)");
+    for (i = 0; i < sizeof(widths) / sizeof(widths[0]); ++i)
+    {
+        if (benchWidth(&api.vector, widths[i]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+// Cost of a single growth step as a function of the buffer size.
+static int growthCurve(fdsa_vector_api *vecApi)
+{
+    puts("bytes before growth, growth time (us)");
+
+    uint64_t zero = 0;
+    size_t elements;
+    for (elements = 1 << 10; elements <= (1 << 25); elements <<= 1)
+    {
+        fdsa_vector *vec = vecApi->create(sizeof(uint64_t));
+        if (!vec)
+        {
+            fputs("Fail to create vector.\n", stderr);
+            return 1;
+        }
+
+        if (vecApi->resize(vec, elements, &zero) == fdsa_failed)
+        {
+            fputs("Fail to resize.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+
+        uint64_t start = benchNow();
+        if (vecApi->reserve(vec, elements * 2) == fdsa_failed)
+        {
+            fputs("Fail to reserve.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+
+        uint64_t end = benchNow();
+        printf("%zu, %.3f\n", elements * sizeof(uint64_t),
+               (double)(end - start) / 1000.0);
+        vecApi->destory(vec);
+    }
+
+    return 0;
+}
+
+// End-to-end cost of filling a vector with pushBack.
+static int pushBackFill(fdsa_vector_api *vecApi)
+{
+    const size_t count = 1 << 24;
+    fdsa_vector *vec = vecApi->create(sizeof(uint64_t));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return 1;
+    }
+
+    uint64_t start = benchNow();
+    uint64_t i;
+    for (i = 0; i < count; ++i)
+    {
+        if (vecApi->pushBack(vec, &i) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    uint64_t end = benchNow();
+    printf("pushBack %zu elements: %.3f ms\n", count,
+           (double)(end - start) / 1000000.0);
+    return (vecApi->destory(vec) == fdsa_failed);
+}
+
+int main()
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    if (growthCurve(&api.vector))
+    {
+        return 1;
+    }
+
+    return pushBackFill(&api.vector);
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+#define BENCH_LOOKUPS 20000000
+
+// Random reads over the raw buffer, so that the time is spent in cache
+// and TLB misses rather than in the vector API.
+static int benchLookups(fdsa_vector_api *api,
+                        const char *name,
+                        unsigned flags,
+                        size_t count)
+{
+    fdsa_vector *vec = api->createEx(sizeof(uint64_t), flags);
+    uint64_t one = 1;
+    if (!vec || api->resize(vec, count, &one) == fdsa_failed)
+    {
+        fprintf(stderr, "%s: fail to allocate %zu elements.\n", name, count);
+        if (vec) api->destory(vec);
+        return 1;
+    }
+
+    const uint64_t *data = api->data(vec);
+    uint64_t state = 88172645463325252ULL;
+    uint64_t sum = 0;
+    size_t i;
+    uint64_t start = benchNow();
+    for (i = 0; i < BENCH_LOOKUPS; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        sum += data[state % count];
+    }
+
+    double elapsed = (double)(benchNow() - start);
+    printf("%s: %.3f ms, %.2f ns per lookup\n", name,
+           elapsed / 1000000.0, elapsed / BENCH_LOOKUPS);
+    if (sum != BENCH_LOOKUPS)
+    {
+        fputs("Result mismatch.\n", stderr);
+        api->destory(vec);
+        return 1;
+    }
+
+    return (api->destory(vec) == fdsa_failed);
+}
+
+// usage: benchVectorHugePages [count], the default is 256M elements (2 GiB)
+int main(int argc, char **argv)
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    size_t count = 256 * 1024 * 1024;
+    if (argc > 1)
+    {
+        count = (size_t)strtoull(argv[1], NULL, 10);
+    }
+
+    if (!count)
+    {
+        fputs("Invalid element count.\n", stderr);
+        return 1;
+    }
+
+    printf("elements: %zu, lookups: %d\n", count, BENCH_LOOKUPS);
+    return benchLookups(&api.vector, "regular pages",
+                        fdsa_vector_lockNone, count) ||
+           benchLookups(&api.vector, "fdsa_vector_hugePages",
+                        fdsa_vector_lockNone | fdsa_vector_hugePages, count) ||
+           benchLookups(&api.vector, "fdsa_vector_hugeTLB",
+                        fdsa_vector_lockNone | fdsa_vector_hugeTLB, count);
+}
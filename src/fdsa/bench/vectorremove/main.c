@@ -0,0 +1,121 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+// remove the elements whose low bits are below 30 out of 100
+#define BENCH_REMOVE_PERCENT 30
+
+static int isRemoved(const void *element, void *ctx)
+{
+    (void)ctx;
+    return (*(const uint64_t *)element % 100) < BENCH_REMOVE_PERCENT;
+}
+
+// usage: benchVectorRemove [count], the default is 50M elements
+int main(int argc, char **argv)
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    size_t count = 50000000;
+    if (argc > 1)
+    {
+        count = (size_t)strtoull(argv[1], NULL, 10);
+    }
+
+    uint64_t *keys = malloc(count * sizeof(uint64_t));
+    fdsa_vector *vec = api.vector.create(sizeof(uint64_t));
+    fdsa_vector *rebuilt = api.vector.create(sizeof(uint64_t));
+    if (!keys || !vec || !rebuilt)
+    {
+        fputs("Fail to allocate memory.\n", stderr);
+        return 1;
+    }
+
+    uint64_t state = 88172645463325252ULL;
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        keys[i] = state;
+    }
+
+    printf("elements: %zu\n", count);
+
+    // rebuild through fdsa_vector_at and fdsa_vector_pushBack
+    if (api.vector.append(vec, keys, count) == fdsa_failed)
+    {
+        fputs("Fail to append.\n", stderr);
+        return 1;
+    }
+
+    uint64_t start = benchNow();
+    for (i = 0; i < count; ++i)
+    {
+        uint64_t key;
+        api.vector.at(vec, i, &key);
+        if (!isRemoved(&key, NULL))
+        {
+            api.vector.pushBack(rebuilt, &key);
+        }
+    }
+
+    printf("rebuild: %.3f ms\n", (double)(benchNow() - start) / 1000000.0);
+
+    // fdsa_vector_removeIf
+    size_t removed = 0;
+    start = benchNow();
+    api.vector.removeIf(vec, isRemoved, NULL, &removed);
+    printf("fdsa_vector_removeIf: %.3f ms, %zu removed\n",
+           (double)(benchNow() - start) / 1000000.0, removed);
+
+    // fdsa_vector_removeIfKey on the key modulo 100, stored in place
+    api.vector.clear(vec);
+    for (i = 0; i < count; ++i)
+    {
+        keys[i] %= 100;
+    }
+
+    api.vector.append(vec, keys, count);
+    uint64_t limit = BENCH_REMOVE_PERCENT;
+    start = benchNow();
+    api.vector.removeIfKey(vec, 0, sizeof(uint64_t), 0, fdsa_vector_cmpLess,
+                           &limit, &removed);
+    printf("fdsa_vector_removeIfKey: %.3f ms, %zu removed\n",
+           (double)(benchNow() - start) / 1000000.0, removed);
+
+    free(keys);
+    api.vector.destory(rebuilt);
+    return (api.vector.destory(vec) == fdsa_failed);
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+static size_t allocCount = 0;
+
+#ifdef __GLIBC__
+// Count heap allocations made by the library and the C++ runtime.
+// These definitions interpose the glibc allocator for the whole process,
+// so they must stay visible despite -fvisibility=hidden.
+#define BENCH_INTERPOSE __attribute__((visibility("default")))
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void *__libc_memalign(size_t, size_t);
+
+BENCH_INTERPOSE void *malloc(size_t size)
+{
+    ++allocCount;
+    return __libc_malloc(size);
+}
+
+BENCH_INTERPOSE void *calloc(size_t count, size_t size)
+{
+    ++allocCount;
+    return __libc_calloc(count, size);
+}
+
+BENCH_INTERPOSE void *realloc(void *ptr, size_t size)
+{
+    ++allocCount;
+    return __libc_realloc(ptr, size);
+}
+
+BENCH_INTERPOSE int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    ++allocCount;
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : 12; // ENOMEM
+}
+#endif
+
+// Create, fill with 0 - 16 elements and destroy many short vectors.
+static int benchSmall(fdsa_vector_api *vecApi, unsigned flags,
+                      const char *name)
+{
+    const size_t count = 200000;
+    size_t before = allocCount;
+    uint64_t start = benchNow();
+
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        fdsa_vector *vec = vecApi->createEx(sizeof(int), flags);
+        if (!vec)
+        {
+            fputs("Fail to create vector.\n", stderr);
+            return 1;
+        }
+
+        int j;
+        for (j = 0; j < (int)(i % 17); ++j)
+        {
+            vecApi->pushBack(vec, &j);
+        }
+
+        vecApi->destory(vec);
+    }
+
+    uint64_t end = benchNow();
+    printf("%s, %zu, %.3f\n", name, allocCount - before,
+           (double)(end - start) / 1000000.0);
+    return 0;
+}
+
+int main()
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+#ifndef __GLIBC__
+    puts("allocation counting needs glibc, counts below are 0");
+#endif
+
+    puts("mode, allocations, time (ms)");
+    if (benchSmall(&api.vector, 0, "heap"))
+    {
+        return 1;
+    }
+
+    return benchSmall(&api.vector, fdsa_vector_inlineStorage, "inline");
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchutil.h"
+#include "fdsa.h"
+
+static int cmpU64(const void *lhs, const void *rhs)
+{
+    uint64_t a = *(const uint64_t *)lhs;
+    uint64_t b = *(const uint64_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+// usage: benchVectorSort [count], the default is 100M elements
+int main(int argc, char **argv)
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    size_t count = 100000000;
+    if (argc > 1)
+    {
+        count = (size_t)strtoull(argv[1], NULL, 10);
+    }
+
+    uint64_t *keys = malloc(count * sizeof(uint64_t));
+    fdsa_vector *vec = api.vector.create(sizeof(uint64_t));
+    if (!keys || !vec)
+    {
+        fputs("Fail to allocate memory.\n", stderr);
+        return 1;
+    }
+
+    uint64_t state = 88172645463325252ULL;
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        keys[i] = state;
+    }
+
+    printf("elements: %zu\n", count);
+
+    // fdsa_vector_sort
+    if (api.vector.append(vec, keys, count) == fdsa_failed)
+    {
+        fputs("Fail to append.\n", stderr);
+        return 1;
+    }
+
+    uint64_t start = benchNow();
+    api.vector.sort(vec, cmpU64);
+    printf("fdsa_vector_sort: %.3f ms\n",
+           (double)(benchNow() - start) / 1000000.0);
+
+    // fdsa_vector_radixSort
+    api.vector.clear(vec);
+    api.vector.append(vec, keys, count);
+    start = benchNow();
+    api.vector.radixSort(vec, 0, sizeof(uint64_t), 0);
+    printf("fdsa_vector_radixSort: %.3f ms\n",
+           (double)(benchNow() - start) / 1000000.0);
+
+    // single-threaded qsort
+    start = benchNow();
+    qsort(keys, count, sizeof(uint64_t), cmpU64);
+    printf("qsort: %.3f ms\n", (double)(benchNow() - start) / 1000000.0);
+
+    if (memcmp(keys, api.vector.data(vec), count * sizeof(uint64_t)))
+    {
+        fputs("Result mismatch.\n", stderr);
+        return 1;
+    }
+
+    free(keys);
+    return (api.vector.destory(vec) == fdsa_failed);
+}
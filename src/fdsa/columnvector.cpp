@@ -0,0 +1,412 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "columnvector.h"
+#include "lock.h"
+
+#include "include/internal/vector.h"
+
+// column buffers start on a cache line
+#define FDSA_COLUMNVECTOR_ALIGN 64
+
+typedef struct fdsa_columnVector
+{
+    fdsa_vector **columns = NULL; // unlocked, guarded by lock
+
+    size_t *sizes = NULL;
+
+    size_t *offsets = NULL; // offset of each column in a row
+
+    size_t columnCount = 0;
+
+    size_t size = 0;
+
+    size_t capacity = 0; // every column holds at least this many
+
+    fdsa_lock lock;
+} fdsa_columnVector;
+
+static void fdsa_columnVector_free(fdsa_columnVector *vec)
+{
+    if (vec->columns)
+    {
+        size_t i;
+        for (i = 0; i < vec->columnCount; ++i)
+        {
+            fdsa_vector_destroy(vec->columns[i]);
+        }
+    }
+
+    delete[] vec->columns;
+    delete[] vec->sizes;
+    delete[] vec->offsets;
+    delete vec;
+}
+
+// Reserve newSize rows in every column. A failure leaves some columns
+// larger than capacity, which is harmless.
+// caller must hold vec->lock
+static fdsa_exitstate fdsa_columnVector_reserveInternal(fdsa_columnVector *vec,
+                                                        size_t newSize)
+{
+    if (newSize <= vec->capacity)
+    {
+        // do nothing
+        return fdsa_success;
+    }
+
+    size_t i;
+    for (i = 0; i < vec->columnCount; ++i)
+    {
+        if (fdsa_vector_reserve(vec->columns[i], newSize) == fdsa_failed)
+        {
+            return fdsa_failed;
+        }
+    }
+
+    vec->capacity = newSize;
+    return fdsa_success;
+}
+
+extern "C"
+{
+
+fdsa_exitstate fdsa_columnVector_init(fdsa_columnVector_api *ret)
+{
+    if (!ret) return fdsa_failed;
+
+    ret->create = fdsa_columnVector_create;
+    ret->createEx = fdsa_columnVector_createEx;
+    ret->destory = fdsa_columnVector_destroy;
+    ret->at = fdsa_columnVector_at;
+    ret->setValue = fdsa_columnVector_setValue;
+    ret->field = fdsa_columnVector_field;
+    ret->setField = fdsa_columnVector_setField;
+    ret->pushBack = fdsa_columnVector_pushBack;
+    ret->clear = fdsa_columnVector_clear;
+    ret->size = fdsa_columnVector_size;
+    ret->capacity = fdsa_columnVector_capacity;
+    ret->reserve = fdsa_columnVector_reserve;
+    ret->columnCount = fdsa_columnVector_columnCount;
+    ret->columnData = fdsa_columnVector_columnData;
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_columnVector *fdsa_columnVector_create(size_t columns,
+                                                     const size_t *sizes,
+                                                     const size_t *offsets)
+{
+    return fdsa_columnVector_createEx(columns, sizes, offsets,
+                                      fdsa_vector_lockMutex);
+}
+
+FDSA_API fdsa_columnVector *fdsa_columnVector_createEx(size_t columns,
+                                                       const size_t *sizes,
+                                                       const size_t *offsets,
+                                                       unsigned flags)
+{
+    if (!columns || !sizes || (flags & ~fdsa_vector_lockMask))
+    {
+        return NULL;
+    }
+
+    fdsa_lockPolicy policy;
+    if (fdsa_lock_policyFromFlags(flags, &policy) == fdsa_failed)
+    {
+        return NULL;
+    }
+
+    fdsa_columnVector *vec = new (std::nothrow) fdsa_columnVector;
+    if (!vec)
+    {
+        return NULL;
+    }
+
+    vec->columns = new (std::nothrow) fdsa_vector*[columns]();
+    vec->sizes = new (std::nothrow) size_t[columns];
+    vec->offsets = new (std::nothrow) size_t[columns];
+    if (!vec->columns || !vec->sizes || !vec->offsets)
+    {
+        fdsa_columnVector_free(vec);
+        return NULL;
+    }
+
+    vec->columnCount = columns;
+    size_t offset = 0;
+    size_t i;
+    for (i = 0; i < columns; ++i)
+    {
+        vec->sizes[i] = sizes[i];
+        vec->offsets[i] = offsets ? offsets[i] : offset;
+        offset += sizes[i];
+
+        // fdsa_vector_createAligned rejects a zero size
+        vec->columns[i] = fdsa_vector_createAligned(sizes[i],
+                                                    fdsa_vector_lockNone,
+                                                    FDSA_COLUMNVECTOR_ALIGN);
+        if (!vec->columns[i])
+        {
+            fdsa_columnVector_free(vec);
+            return NULL;
+        }
+    }
+
+    vec->lock.policy = policy;
+    return vec;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_destroy(fdsa_columnVector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    vec->lock.lock();
+    vec->lock.unlock();
+    fdsa_columnVector_free(vec);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_at(fdsa_columnVector *vec,
+                                             size_t index,
+                                             void *row)
+{
+    if (!vec || !row)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    uint8_t *dst = static_cast<uint8_t *>(row);
+    size_t i;
+    for (i = 0; i < vec->columnCount; ++i)
+    {
+        const uint8_t *column = static_cast<const uint8_t *>(
+            fdsa_vector_data(vec->columns[i]));
+        memcpy(dst + vec->offsets[i],
+               column + (index * vec->sizes[i]),
+               vec->sizes[i]);
+    }
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_setValue(fdsa_columnVector *vec,
+                                                   size_t index,
+                                                   const void *row)
+{
+    if (!vec || !row)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    // every index is in range, so no column fails after another succeeded
+    const uint8_t *src = static_cast<const uint8_t *>(row);
+    size_t i;
+    for (i = 0; i < vec->columnCount; ++i)
+    {
+        if (fdsa_vector_setValue(vec->columns[i], index,
+                                 src + vec->offsets[i]) == fdsa_failed)
+        {
+            return fdsa_failed;
+        }
+    }
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_field(fdsa_columnVector *vec,
+                                                size_t column,
+                                                size_t index,
+                                                void *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (column >= vec->columnCount || index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    return fdsa_vector_at(vec->columns[column], index, dst);
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_setField(fdsa_columnVector *vec,
+                                                   size_t column,
+                                                   size_t index,
+                                                   const void *src)
+{
+    if (!vec || !src)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (column >= vec->columnCount || index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    return fdsa_vector_setValue(vec->columns[column], index, src);
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_pushBack(fdsa_columnVector *vec,
+                                                   const void *row)
+{
+    if (!vec || !row)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (vec->size == vec->capacity)
+    {
+        // grow every column first, so that the row is never half pushed
+        size_t newSize = vec->capacity ? vec->capacity * 2 : 4;
+        if (newSize < vec->capacity ||
+            fdsa_columnVector_reserveInternal(vec, newSize) == fdsa_failed)
+        {
+            return fdsa_failed;
+        }
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(row);
+    size_t i;
+    for (i = 0; i < vec->columnCount; ++i)
+    {
+        if (fdsa_vector_pushBack(vec->columns[i],
+                                 src + vec->offsets[i]) == fdsa_failed)
+        {
+            // take the row back out of the columns it reached
+            while (i--)
+            {
+                fdsa_vector_eraseAt(vec->columns[i], vec->size);
+            }
+
+            return fdsa_failed;
+        }
+    }
+
+    ++vec->size;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_clear(fdsa_columnVector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    size_t i;
+    for (i = 0; i < vec->columnCount; ++i)
+    {
+        fdsa_vector_clear(vec->columns[i]);
+    }
+
+    vec->size = 0;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_size(fdsa_columnVector *vec,
+                                               size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = vec->size;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_capacity(fdsa_columnVector *vec,
+                                                   size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = vec->capacity;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_reserve(fdsa_columnVector *vec,
+                                                  size_t newSize)
+{
+    if (!vec) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    return fdsa_columnVector_reserveInternal(vec, newSize);
+}
+
+FDSA_API fdsa_exitstate fdsa_columnVector_columnCount(fdsa_columnVector *vec,
+                                                      size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    // fixed at creation
+    *dst = vec->columnCount;
+    return fdsa_success;
+}
+
+FDSA_API const void *fdsa_columnVector_columnData(fdsa_columnVector *vec,
+                                                  size_t column)
+{
+    if (!vec) return NULL;
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (column >= vec->columnCount)
+    {
+        return NULL;
+    }
+
+    return fdsa_vector_data(vec->columns[column]);
+}
+
+} // end extern "C"
@@ -0,0 +1,508 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <new>
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "concurrentvector.h"
+#include "segment.h"
+
+// the first segment holds 256 elements
+#define FDSA_CONCURRENTVECTOR_BASESHIFT 8
+
+typedef struct concurrentVectorSegment
+{
+    uint8_t *data = NULL;
+
+    std::atomic<uint8_t> *ready = NULL; // 1 when the slot is published
+} concurrentVectorSegment;
+
+typedef struct fdsa_concurrentVector
+{
+    size_t sizeOfData = 0;
+
+    size_t maxSize = 0;
+
+    std::atomic<size_t> reserved{0}; // slots handed out by claim
+
+    std::atomic<size_t> committed{0}; // leading slots that are published
+
+    std::atomic<concurrentVectorSegment *> segments[FDSA_SEGMENT_MAX] = {};
+} fdsa_concurrentVector;
+
+static void destroyConcurrentVectorSegment(concurrentVectorSegment *seg)
+{
+    if (!seg) return;
+
+    free(seg->data);
+    delete[] seg->ready;
+    delete seg;
+}
+
+static concurrentVectorSegment *fdsa_concurrentVector_segment(
+        fdsa_concurrentVector *vec,
+        unsigned index)
+{
+    concurrentVectorSegment *seg =
+        vec->segments[index].load(std::memory_order_acquire);
+    if (seg)
+    {
+        return seg;
+    }
+
+    size_t length = fdsa_segment_length(index,
+                                        FDSA_CONCURRENTVECTOR_BASESHIFT);
+    if (length > SIZE_MAX / vec->sizeOfData)
+    {
+        return NULL;
+    }
+
+    seg = new (std::nothrow) concurrentVectorSegment;
+    if (!seg)
+    {
+        return NULL;
+    }
+
+    seg->data = static_cast<uint8_t *>(malloc(length * vec->sizeOfData));
+    seg->ready = new (std::nothrow) std::atomic<uint8_t>[length]();
+    if (!seg->data || !seg->ready)
+    {
+        destroyConcurrentVectorSegment(seg);
+        return NULL;
+    }
+
+    // another producer may install the same segment first
+    concurrentVectorSegment *expected = NULL;
+    if (!vec->segments[index].compare_exchange_strong(
+            expected, seg,
+            std::memory_order_acq_rel,
+            std::memory_order_acquire))
+    {
+        destroyConcurrentVectorSegment(seg);
+        return expected;
+    }
+
+    return seg;
+}
+
+// Move committed over the published slots that follow it.
+static size_t fdsa_concurrentVector_advance(fdsa_concurrentVector *vec)
+{
+    size_t cur = vec->committed.load(std::memory_order_acquire);
+    size_t end = vec->reserved.load(std::memory_order_acquire);
+    size_t next = cur;
+
+    while (next < end)
+    {
+        unsigned index = fdsa_segment_of(next,
+                                         FDSA_CONCURRENTVECTOR_BASESHIFT);
+        concurrentVectorSegment *seg =
+            vec->segments[index].load(std::memory_order_acquire);
+        if (!seg) break;
+
+        size_t offset = next - fdsa_segment_begin(
+                                   index, FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t length = fdsa_segment_length(index,
+                                            FDSA_CONCURRENTVECTOR_BASESHIFT);
+        while (offset < length && next < end &&
+               seg->ready[offset].load(std::memory_order_acquire))
+        {
+            ++offset;
+            ++next;
+        }
+
+        if (offset < length) break;
+    }
+
+    while (next > cur)
+    {
+        if (vec->committed.compare_exchange_weak(cur, next,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+        {
+            return next;
+        }
+    }
+
+    return cur;
+}
+
+// Install the segments that hold [first, first + count).
+static bool fdsa_concurrentVector_install(fdsa_concurrentVector *vec,
+                                          size_t first,
+                                          size_t count)
+{
+    unsigned last = fdsa_segment_of(first + count - 1,
+                                    FDSA_CONCURRENTVECTOR_BASESHIFT);
+    unsigned i;
+    for (i = fdsa_segment_of(first, FDSA_CONCURRENTVECTOR_BASESHIFT);
+         i <= last;
+         ++i)
+    {
+        if (!fdsa_concurrentVector_segment(vec, i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Mark [first, first + count) as published and move committed over it.
+// A hole is a range whose claim failed after it was reserved, it is
+// zero-filled where its segments exist so that committed can pass it.
+// A segment that cannot be allocated stops committed at its start.
+static bool fdsa_concurrentVector_mark(fdsa_concurrentVector *vec,
+                                       size_t first,
+                                       size_t count,
+                                       bool hole)
+{
+    size_t index = first;
+    while (index < first + count)
+    {
+        unsigned seg = fdsa_segment_of(index,
+                                       FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t begin = fdsa_segment_begin(seg,
+                                          FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t length = fdsa_segment_length(seg,
+                                            FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t offset = index - begin;
+        size_t n = length - offset;
+        if (n > first + count - index)
+        {
+            n = first + count - index;
+        }
+
+        concurrentVectorSegment *segment =
+            hole ? fdsa_concurrentVector_segment(vec, seg) :
+                   vec->segments[seg].load(std::memory_order_acquire);
+        if (!segment)
+        {
+            if (!hole) return false;
+
+            index += n;
+            continue;
+        }
+
+        if (hole)
+        {
+            memset(segment->data + (offset * vec->sizeOfData), 0,
+                   n * vec->sizeOfData);
+        }
+
+        for (index += n; n; --n, ++offset)
+        {
+            segment->ready[offset].store(1, std::memory_order_release);
+        }
+    }
+
+    // only the producer right behind the published prefix moves it
+    if (vec->committed.load(std::memory_order_relaxed) == first)
+    {
+        fdsa_concurrentVector_advance(vec);
+    }
+
+    return true;
+}
+
+extern "C"
+{
+
+fdsa_exitstate fdsa_concurrentVector_init(fdsa_concurrentVector_api *ret)
+{
+    if (!ret) return fdsa_failed;
+
+    ret->create = fdsa_concurrentVector_create;
+    ret->destory = fdsa_concurrentVector_destroy;
+    ret->claim = fdsa_concurrentVector_claim;
+    ret->slot = fdsa_concurrentVector_slot;
+    ret->publish = fdsa_concurrentVector_publish;
+    ret->pushBack = fdsa_concurrentVector_pushBack;
+    ret->append = fdsa_concurrentVector_append;
+    ret->at = fdsa_concurrentVector_at;
+    ret->size = fdsa_concurrentVector_size;
+    ret->toVector = fdsa_concurrentVector_toVector;
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_concurrentVector *fdsa_concurrentVector_create(
+        size_t sizeOfData)
+{
+    if (!sizeOfData)
+    {
+        return NULL;
+    }
+
+    fdsa_concurrentVector *vec = new (std::nothrow) fdsa_concurrentVector;
+    if (!vec)
+    {
+        return NULL;
+    }
+
+    vec->sizeOfData = sizeOfData;
+    vec->maxSize = fdsa_segment_begin(
+        fdsa_segment_count(FDSA_CONCURRENTVECTOR_BASESHIFT),
+        FDSA_CONCURRENTVECTOR_BASESHIFT);
+    return vec;
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_destroy(
+        fdsa_concurrentVector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    size_t i;
+    for (i = 0; i < FDSA_SEGMENT_MAX; ++i)
+    {
+        destroyConcurrentVectorSegment(
+            vec->segments[i].load(std::memory_order_acquire));
+    }
+
+    delete vec;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_claim(
+        fdsa_concurrentVector *vec,
+        size_t count,
+        size_t *first)
+{
+    if (!vec || !count || !first)
+    {
+        return fdsa_failed;
+    }
+
+    // No claim this big fits in memory, and the limit keeps the claims
+    // that race past maxSize from wrapping reserved around.
+    size_t begin = vec->reserved.load(std::memory_order_relaxed);
+    if (count > (vec->maxSize >> FDSA_CONCURRENTVECTOR_BASESHIFT) ||
+        begin > vec->maxSize - count)
+    {
+        return fdsa_failed;
+    }
+
+    // Install the segments the claim would get now, so a claim that cannot
+    // be stored fails before it reserves anything.
+    if (!fdsa_concurrentVector_install(vec, begin, count))
+    {
+        return fdsa_failed;
+    }
+
+    begin = vec->reserved.fetch_add(count, std::memory_order_acq_rel);
+    if (begin > vec->maxSize - count)
+    {
+        // every later claim lands past maxSize too,
+        // so committed can stop at begin for good
+        return fdsa_failed;
+    }
+
+    // other producers moved reserved, the segments may still be missing
+    if (!fdsa_concurrentVector_install(vec, begin, count))
+    {
+        fdsa_concurrentVector_mark(vec, begin, count, true);
+        return fdsa_failed;
+    }
+
+    *first = begin;
+    return fdsa_success;
+}
+
+FDSA_API void *fdsa_concurrentVector_slot(fdsa_concurrentVector *vec,
+                                          size_t index)
+{
+    if (!vec || index >= vec->reserved.load(std::memory_order_acquire))
+    {
+        return NULL;
+    }
+
+    unsigned seg = fdsa_segment_of(index, FDSA_CONCURRENTVECTOR_BASESHIFT);
+    concurrentVectorSegment *segment =
+        vec->segments[seg].load(std::memory_order_acquire);
+    if (!segment)
+    {
+        return NULL;
+    }
+
+    size_t offset = index - fdsa_segment_begin(
+                                seg, FDSA_CONCURRENTVECTOR_BASESHIFT);
+    return segment->data + (offset * vec->sizeOfData);
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_publish(
+        fdsa_concurrentVector *vec,
+        size_t first,
+        size_t count)
+{
+    if (!vec || !count)
+    {
+        return fdsa_failed;
+    }
+
+    size_t end = vec->reserved.load(std::memory_order_acquire);
+    if (first >= end || count > end - first)
+    {
+        return fdsa_failed;
+    }
+
+    return fdsa_concurrentVector_mark(vec, first, count, false) ?
+               fdsa_success : fdsa_failed;
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_pushBack(
+        fdsa_concurrentVector *vec,
+        const void *src)
+{
+    return fdsa_concurrentVector_append(vec, src, 1);
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_append(
+        fdsa_concurrentVector *vec,
+        const void *in,
+        size_t inLen)
+{
+    if (!vec || !in || !inLen)
+    {
+        return fdsa_failed;
+    }
+
+    size_t first;
+    if (fdsa_concurrentVector_claim(vec, inLen, &first) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(in);
+    size_t index = first;
+    while (index < first + inLen)
+    {
+        unsigned seg = fdsa_segment_of(index,
+                                       FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t begin = fdsa_segment_begin(seg,
+                                          FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t length = fdsa_segment_length(seg,
+                                            FDSA_CONCURRENTVECTOR_BASESHIFT);
+        size_t count = begin + length - index;
+        if (count > first + inLen - index)
+        {
+            count = first + inLen - index;
+        }
+
+        uint8_t *dst = vec->segments[seg].load(std::memory_order_acquire)
+                           ->data + ((index - begin) * vec->sizeOfData);
+        memcpy(dst, src, count * vec->sizeOfData);
+        src += count * vec->sizeOfData;
+        index += count;
+    }
+
+    return fdsa_concurrentVector_publish(vec, first, inLen);
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_at(fdsa_concurrentVector *vec,
+                                                 size_t index,
+                                                 void *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    if (index >= vec->committed.load(std::memory_order_acquire) &&
+        index >= fdsa_concurrentVector_advance(vec))
+    {
+        return fdsa_failed;
+    }
+
+    unsigned seg = fdsa_segment_of(index, FDSA_CONCURRENTVECTOR_BASESHIFT);
+    size_t offset = index - fdsa_segment_begin(
+                                seg, FDSA_CONCURRENTVECTOR_BASESHIFT);
+    memcpy(dst,
+           vec->segments[seg].load(std::memory_order_acquire)->data +
+               (offset * vec->sizeOfData),
+           vec->sizeOfData);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_size(
+        fdsa_concurrentVector *vec,
+        size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    *dst = fdsa_concurrentVector_advance(vec);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_vector *fdsa_concurrentVector_toVector(
+        fdsa_concurrentVector *vec)
+{
+    if (!vec) return NULL;
+
+    size_t size = fdsa_concurrentVector_advance(vec);
+    fdsa_vector *ret = fdsa_vector_create(vec->sizeOfData);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    if (fdsa_vector_reserve(ret, size) == fdsa_failed)
+    {
+        fdsa_vector_destroy(ret);
+        return NULL;
+    }
+
+    size_t index = 0;
+    unsigned seg = 0;
+    while (index < size)
+    {
+        size_t count = fdsa_segment_length(seg,
+                                           FDSA_CONCURRENTVECTOR_BASESHIFT);
+        if (count > size - index)
+        {
+            count = size - index;
+        }
+
+        if (fdsa_vector_append(
+                ret,
+                vec->segments[seg].load(std::memory_order_acquire)->data,
+                count) == fdsa_failed)
+        {
+            fdsa_vector_destroy(ret);
+            return NULL;
+        }
+
+        index += count;
+        ++seg;
+    }
+
+    return ret;
+}
+
+} // end extern "C"
@@ -24,9 +24,12 @@
 #include <stdlib.h>
 
 #include "include/fdsa.h"
+#include "columnvector.h"
+#include "concurrentvector.h"
 #include "ptrlinkedlist.h"
 #include "ptrmap.h"
 #include "ptrvector.h"
+#include "segmentedvector.h"
 #include "vector.h"
 
 FDSA_API fdsa_exitstate fdsa_init(fDSA *ret)
@@ -36,6 +39,16 @@ FDSA_API fdsa_exitstate fdsa_init(fDSA *ret)
         return fdsa_failed;
     }
 
+    if (fdsa_columnVector_init(&ret->columnVector) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_concurrentVector_init(&ret->concurrentVector) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
     if (fdsa_ptrLinkedList_init(&ret->ptrLinkedList) == fdsa_failed)
     {
         return fdsa_failed;
@@ -51,6 +64,11 @@ FDSA_API fdsa_exitstate fdsa_init(fDSA *ret)
         return fdsa_failed;
     }
 
+    if (fdsa_segmentedVector_init(&ret->segmentedVector) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
     if (fdsa_vector_init(&ret->vector) == fdsa_failed)
     {
         return fdsa_failed;
@@ -0,0 +1,156 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#include "include/internal/defines.h"
+#include "include/internal/vector.h"
+
+typedef enum fdsa_lockPolicy
+{
+    fdsa_lockPolicy_mutex,
+    fdsa_lockPolicy_none,
+    fdsa_lockPolicy_spin,
+    fdsa_lockPolicy_shared
+} fdsa_lockPolicy;
+
+/**
+ * A lock whose implementation is chosen at runtime.
+ * It meets both Lockable and SharedLockable, so it works with
+ * std::lock_guard and std::shared_lock. For the policies other than
+ * fdsa_lockPolicy_shared, shared ownership is the same as exclusive one.
+ */
+typedef struct fdsa_lock
+{
+    fdsa_lockPolicy policy = fdsa_lockPolicy_mutex;
+
+    std::atomic<bool> spin{false};
+
+    std::mutex mutex;
+
+    std::shared_mutex sharedMutex;
+
+    void lock()
+    {
+        switch (policy)
+        {
+        case fdsa_lockPolicy_none:
+            break;
+        case fdsa_lockPolicy_spin:
+            lockSpin();
+            break;
+        case fdsa_lockPolicy_shared:
+            sharedMutex.lock();
+            break;
+        default:
+            mutex.lock();
+            break;
+        }
+    }
+
+    void unlock()
+    {
+        switch (policy)
+        {
+        case fdsa_lockPolicy_none:
+            break;
+        case fdsa_lockPolicy_spin:
+            spin.store(false, std::memory_order_release);
+            break;
+        case fdsa_lockPolicy_shared:
+            sharedMutex.unlock();
+            break;
+        default:
+            mutex.unlock();
+            break;
+        }
+    }
+
+    void lock_shared()
+    {
+        if (policy == fdsa_lockPolicy_shared)
+        {
+            sharedMutex.lock_shared();
+            return;
+        }
+
+        lock();
+    }
+
+    void unlock_shared()
+    {
+        if (policy == fdsa_lockPolicy_shared)
+        {
+            sharedMutex.unlock_shared();
+            return;
+        }
+
+        unlock();
+    }
+
+    void lockSpin()
+    {
+        unsigned tries = 0;
+        while (spin.exchange(true, std::memory_order_acquire))
+        {
+            // wait on a plain load to keep the cache line shared
+            while (spin.load(std::memory_order_relaxed))
+            {
+                if (++tries > 64)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+} fdsa_lock;
+
+// Map the lock bits of fdsa_vector_flag to a policy.
+static inline fdsa_exitstate fdsa_lock_policyFromFlags(unsigned flags,
+                                                       fdsa_lockPolicy *dst)
+{
+    switch (flags & fdsa_vector_lockMask)
+    {
+    case fdsa_vector_lockMutex:
+        *dst = fdsa_lockPolicy_mutex;
+        break;
+    case fdsa_vector_lockNone:
+        *dst = fdsa_lockPolicy_none;
+        break;
+    case fdsa_vector_lockSpin:
+        *dst = fdsa_lockPolicy_spin;
+        break;
+    case fdsa_vector_lockShared:
+        *dst = fdsa_lockPolicy_shared;
+        break;
+    default:
+        return fdsa_failed;
+    }
+
+    return fdsa_success;
+}
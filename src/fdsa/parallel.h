@@ -0,0 +1,131 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Minimal fork-join helpers for the parallel algorithms.
+
+// Work split between threads should not share a line of this size.
+#define FDSA_CACHE_LINE 64
+
+// FDSA_THREADS_FORCE may not raise the worker count beyond this
+#define FDSA_PARALLEL_FORCE_MAX 64
+
+// The positive integer in environment variable name, 0 if it is unset or
+// not a positive integer.
+static inline size_t fdsa_parallel_envWorkers(const char *name)
+{
+    const char *env = getenv(name);
+    if (!env)
+    {
+        return 0;
+    }
+
+    char *end = NULL;
+    long value = strtol(env, &end, 10);
+    if (end == env || *end != '\0' || value <= 0)
+    {
+        return 0;
+    }
+
+    return static_cast<size_t>(value);
+}
+
+// FDSA_THREADS lowers the number of workers below the number of hardware
+// threads. Values that are not a positive integer are ignored, larger ones
+// are clamped, so one call never starts more threads than the machine has.
+// FDSA_THREADS_FORCE is meant for tests: it sets the worker count
+// regardless of the hardware, up to FDSA_PARALLEL_FORCE_MAX, so that the
+// parallel paths run even on a single CPU.
+static inline size_t fdsa_parallel_workers()
+{
+    size_t force = fdsa_parallel_envWorkers("FDSA_THREADS_FORCE");
+    if (force)
+    {
+        return (force < FDSA_PARALLEL_FORCE_MAX) ?
+               force : FDSA_PARALLEL_FORCE_MAX;
+    }
+
+    unsigned hardware = std::thread::hardware_concurrency();
+    size_t ret = hardware ? hardware : 1;
+
+    size_t limit = fdsa_parallel_envWorkers("FDSA_THREADS");
+    if (limit && limit < ret)
+    {
+        ret = limit;
+    }
+
+    return ret;
+}
+
+// Run func(task) for every task in [0, tasks) on up to
+// fdsa_parallel_workers() threads, the calling thread included.
+// If a thread cannot be started, the remaining threads take its tasks.
+template<typename Func>
+static void fdsa_parallel_run(size_t tasks, Func func)
+{
+    if (!tasks) return;
+
+    size_t workers = fdsa_parallel_workers();
+    if (workers > tasks)
+    {
+        workers = tasks;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]()
+    {
+        size_t task;
+        while ((task = next.fetch_add(1, std::memory_order_relaxed)) < tasks)
+        {
+            func(task);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        threads.reserve(workers - 1);
+        size_t i;
+        for (i = 1; i < workers; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+        // run with the threads that did start
+    }
+
+    worker();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -17,6 +17,7 @@
 *    <http://www.gnu.org/licenses/>.
 */
 
+#include <atomic>
 #include <mutex>
 #include <new>
 
@@ -24,7 +25,15 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "parallel.h"
+#include "prefetch.h"
 #include "ptrvector.h"
+#include "reclaimer.h"
+
+// resize fans deepCopyFunc out to worker threads from this many copies
+#define FDSA_PTRVECTOR_PARALLEL_COPY 4096
+
+#define FDSA_PTRVECTOR_COPY_CHUNK 1024
 
 typedef struct fdsa_ptrVector
 {
@@ -32,13 +41,181 @@ typedef struct fdsa_ptrVector
 
     fdsa_freeFunc freeFunc = NULL;
 
-    size_t size = NULL;
+    size_t size = 0;
 
     size_t capacity = 0;
 
+    double trimThreshold = 0.0; // 0 means the trim policy is off
+
+    size_t trimMinCapacity = 0;
+
+    unsigned reclaimMode = fdsa_ptrVector_reclaimInline;
+
+    uint64_t reclaimTicket = 0; // last batch handed to the reclaimer
+
     std::mutex mutex;
 } fdsa_ptrVector;
 
+// Move the pointers to an array of newCapacity slots,
+// newCapacity >= vec->size. An empty array is released.
+// Slots past vec->size are left uninitialized, they are never read.
+// caller must hold vec->mutex
+static fdsa_exitstate fdsa_ptrVector_reallocInternal(fdsa_ptrVector *vec,
+                                                     size_t newCapacity)
+{
+    uint8_t **newData = NULL;
+    if (newCapacity)
+    {
+        newData = new (std::nothrow) uint8_t*[newCapacity];
+        if (!newData)
+        {
+            return fdsa_failed;
+        }
+    }
+
+    if (vec->data)
+    {
+        if (vec->size)
+        {
+            memcpy(newData, vec->data, vec->size * sizeof(uint8_t *));
+        }
+
+        delete[] vec->data;
+    }
+
+    vec->data = newData;
+    vec->capacity = newCapacity;
+    return fdsa_success;
+}
+
+// Make room for required pointers, at least doubling the capacity so that
+// a sequence of pushBack costs amortized O(1).
+// caller must hold vec->mutex
+static fdsa_exitstate fdsa_ptrVector_growInternal(fdsa_ptrVector *vec,
+                                                  size_t required)
+{
+    if (required <= vec->capacity)
+    {
+        return fdsa_success;
+    }
+
+    size_t maxCapacity = static_cast<size_t>(-1) / sizeof(uint8_t *);
+    if (required > maxCapacity)
+    {
+        return fdsa_failed;
+    }
+
+    size_t newCapacity = (vec->capacity > maxCapacity / 2) ?
+                         maxCapacity : vec->capacity * 2;
+    if (newCapacity < 4) newCapacity = 4;
+    if (newCapacity < required) newCapacity = required;
+
+    return fdsa_ptrVector_reallocInternal(vec, newCapacity);
+}
+
+// Apply the trim policy after the size went down, see
+// fdsa_ptrVector_setTrimPolicy.
+// caller must hold vec->mutex
+static void fdsa_ptrVector_trimInternal(fdsa_ptrVector *vec)
+{
+    if (!(vec->trimThreshold > 0.0) || vec->capacity <= vec->trimMinCapacity)
+    {
+        return;
+    }
+
+    if (static_cast<double>(vec->size) * vec->trimThreshold >=
+        static_cast<double>(vec->capacity))
+    {
+        return;
+    }
+
+    size_t newCapacity = vec->size * 2;
+    if (newCapacity < vec->trimMinCapacity)
+    {
+        newCapacity = vec->trimMinCapacity;
+    }
+
+    // on failure the larger array is kept, which is still valid
+    fdsa_ptrVector_reallocInternal(vec, newCapacity);
+}
+
+// Free the elements of an array swapped out of vec according to mode.
+// Only the deferred mode needs vec, to record the ticket.
+// caller must hold vec->mutex, unless vec is NULL
+static void fdsa_ptrVector_reclaimInternal(fdsa_ptrVector *vec,
+                                           uint8_t **data,
+                                           size_t size,
+                                           fdsa_freeFunc freeFunc,
+                                           unsigned mode)
+{
+    if (!data)
+    {
+        return;
+    }
+
+    uint64_t ticket = 0;
+    if (mode == fdsa_ptrVector_reclaimDeferred &&
+        fdsa_reclaimer_push(data, size, freeFunc, &ticket) == fdsa_success)
+    {
+        if (vec) vec->reclaimTicket = ticket;
+        return;
+    }
+
+    // also the fallback when the reclaimer cannot take the batch
+    fdsa_reclaimer_release(data, size, freeFunc,
+                           mode != fdsa_ptrVector_reclaimInline);
+}
+
+// Free data, an array no longer part of vec, following vec->reclaimMode.
+// Except for queuing a deferred batch, this happens after lock is released.
+// caller must hold vec->mutex through lock
+static void fdsa_ptrVector_releaseInternal(fdsa_ptrVector *vec,
+                                           std::unique_lock<std::mutex> &lock,
+                                           uint8_t **data,
+                                           size_t size)
+{
+    fdsa_freeFunc freeFunc = vec->freeFunc;
+    unsigned mode = vec->reclaimMode;
+    if (mode == fdsa_ptrVector_reclaimDeferred)
+    {
+        // queue under the lock, so that flush sees the ticket
+        fdsa_ptrVector_reclaimInternal(vec, data, size, freeFunc, mode);
+        return;
+    }
+
+    lock.unlock();
+    fdsa_ptrVector_reclaimInternal(NULL, data, size, freeFunc, mode);
+}
+
+// Copy the count pointers at src, about to be removed, to a new array for
+// fdsa_ptrVector_releaseInternal. Without memory they are freed right away
+// and NULL is returned, as when there is nothing to free.
+// caller must hold vec->mutex
+static uint8_t **fdsa_ptrVector_detachInternal(fdsa_ptrVector *vec,
+                                               uint8_t **src,
+                                               size_t count)
+{
+    if (!count || !vec->freeFunc)
+    {
+        return NULL;
+    }
+
+    uint8_t **ret = new (std::nothrow) uint8_t*[count];
+    if (!ret)
+    {
+        size_t i;
+        for (i = 0; i < count; ++i)
+        {
+            if (src[i]) vec->freeFunc(src[i]);
+        }
+
+        return NULL;
+    }
+
+    memcpy(ret, src, count * sizeof(uint8_t *));
+    return ret;
+}
+
 extern "C"
 {
 
@@ -55,7 +232,17 @@ fdsa_exitstate fdsa_ptrVector_init(fdsa_ptrVector_api *ret)
     ret->capacity = fdsa_ptrVector_capacity;
     ret->reserve = fdsa_ptrVector_reserve;
     ret->pushBack = fdsa_ptrVector_pushBack;
+    ret->pushBackN = fdsa_ptrVector_pushBackN;
     ret->resize = fdsa_ptrVector_resize;
+    ret->swapRemove = fdsa_ptrVector_swapRemove;
+    ret->eraseAt = fdsa_ptrVector_eraseAt;
+    ret->eraseRange = fdsa_ptrVector_eraseRange;
+    ret->removeIf = fdsa_ptrVector_removeIf;
+    ret->forEach = fdsa_ptrVector_forEach;
+    ret->shrinkToFit = fdsa_ptrVector_shrinkToFit;
+    ret->setTrimPolicy = fdsa_ptrVector_setTrimPolicy;
+    ret->setReclaimMode = fdsa_ptrVector_setReclaimMode;
+    ret->flush = fdsa_ptrVector_flush;
 
     return fdsa_success;
 }
@@ -81,20 +268,15 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_destroy(fdsa_ptrVector *vec)
     }
 
     vec->mutex.lock();
-    if (vec->data)
-    {
-        size_t i = 0;
-        for (i = 0; i < vec->size; ++i)
-        {
-            if (vec->freeFunc) vec->freeFunc(vec->data[i]);
-        }
-
-        delete[] vec->data;
-        vec->data = NULL;
-    }
-
+    uint8_t **data = vec->data;
+    size_t size = vec->size;
+    fdsa_freeFunc freeFunc = vec->freeFunc;
+    unsigned mode = vec->reclaimMode;
+    vec->data = NULL;
     vec->mutex.unlock();
     delete vec;
+
+    fdsa_ptrVector_reclaimInternal(NULL, data, size, freeFunc, mode);
     return fdsa_success;
 }
 
@@ -142,7 +324,19 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_clear(fdsa_ptrVector *vec)
         return fdsa_failed;
     }
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::unique_lock<std::mutex> lock(vec->mutex);
+    if (vec->reclaimMode != fdsa_ptrVector_reclaimInline)
+    {
+        uint8_t **data = vec->data;
+        size_t size = vec->size;
+        vec->data = NULL;
+        vec->size = 0;
+        vec->capacity = 0;
+
+        fdsa_ptrVector_releaseInternal(vec, lock, data, size);
+        return fdsa_success;
+    }
+
     size_t i = 0;
     for (i = 0; i < vec->size; ++i)
     {
@@ -151,6 +345,7 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_clear(fdsa_ptrVector *vec)
     }
 
     vec->size = 0;
+    fdsa_ptrVector_trimInternal(vec);
     return fdsa_success;
 }
 
@@ -194,27 +389,7 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_reserve(fdsa_ptrVector *vec, size_t newSi
         return fdsa_success;
     }
 
-    uint8_t **newData = new (std::nothrow) uint8_t*[newSize]();
-    if (!newData)
-    {
-        return fdsa_failed;
-    }
-
-    if (vec->data)
-    {
-        size_t i;
-        for (i = 0; i < vec->size; ++i)
-        {
-            newData[i] = vec->data[i];
-        }
-
-        delete[] vec->data;
-    }
-
-    vec->data = newData;
-    vec->capacity = newSize;
-
-    return fdsa_success;
+    return fdsa_ptrVector_reallocInternal(vec, newSize);
 }
 
 FDSA_API fdsa_exitstate fdsa_ptrVector_pushBack(fdsa_ptrVector *vec, void *src)
@@ -227,7 +402,7 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_pushBack(fdsa_ptrVector *vec, void *src)
     std::lock_guard<std::mutex> lock(vec->mutex);
     if (vec->size == vec->capacity)
     {
-        if (fdsa_ptrVector_reserve(vec, vec->capacity + 1) == fdsa_failed)
+        if (fdsa_ptrVector_growInternal(vec, vec->size + 1) == fdsa_failed)
         {
             return fdsa_failed;
         }
@@ -243,6 +418,34 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_pushBack(fdsa_ptrVector *vec, void *src)
     return fdsa_success;
 }
 
+FDSA_API fdsa_exitstate fdsa_ptrVector_pushBackN(fdsa_ptrVector *vec,
+                                                 void **src,
+                                                 size_t count)
+{
+    if (!vec || (!src && count))
+    {
+        return fdsa_failed;
+    }
+
+    if (!count)
+    {
+        // do nothing
+        return fdsa_success;
+    }
+
+    std::lock_guard<std::mutex> lock(vec->mutex);
+    if (count > static_cast<size_t>(-1) - vec->size ||
+        fdsa_ptrVector_growInternal(vec, vec->size + count) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    memcpy(vec->data + vec->size, src, count * sizeof(uint8_t *));
+    vec->size += count;
+
+    return fdsa_success;
+}
+
 FDSA_API fdsa_exitstate fdsa_ptrVector_resize(fdsa_ptrVector *vec,
                                               size_t amount,
                                               void *src,
@@ -253,47 +456,333 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_resize(fdsa_ptrVector *vec,
         return fdsa_failed;
     }
 
-    if (vec->capacity < amount)
+    std::unique_lock<std::mutex> lock(vec->mutex);
+    size_t i;
+    if (vec->size > amount)
+    {
+        // the dropped elements are freed after the lock is released
+        size_t count = vec->size - amount;
+        uint8_t **removed = fdsa_ptrVector_detachInternal(vec,
+                                                          vec->data + amount,
+                                                          count);
+        vec->size = amount;
+        fdsa_ptrVector_trimInternal(vec);
+
+        fdsa_ptrVector_releaseInternal(vec, lock, removed, count);
+        return fdsa_success;
+    }
+
+    if (vec->size == amount)
+    {
+        // do nothing
+        return fdsa_success;
+    }
+
+    if (!deepCopyFunc ||
+        (amount > vec->capacity &&
+         fdsa_ptrVector_reallocInternal(vec, amount) == fdsa_failed))
+    {
+        return fdsa_failed;
+    }
+
+    // copies go straight into the reserved slots, NULL marks the ones
+    // to free on rollback
+    uint8_t **data = vec->data;
+    size_t first = vec->size;
+    size_t count = amount - first;
+    memset(data + first, 0, count * sizeof(uint8_t *));
+
+    std::atomic<bool> failed{false};
+    size_t chunk = FDSA_PTRVECTOR_COPY_CHUNK;
+    size_t tasks = (count + chunk - 1) / chunk;
+    auto copyTask = [&](size_t task)
     {
-        if (fdsa_ptrVector_reserve(vec, amount) == fdsa_failed)
+        size_t end = first + (task + 1) * chunk;
+        if (end > amount) end = amount;
+
+        size_t j;
+        for (j = first + task * chunk; j < end; ++j)
         {
-            return fdsa_failed;
+            if (failed.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            data[j] = reinterpret_cast<uint8_t *>(deepCopyFunc(src));
+            if (!data[j])
+            {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    };
+
+    if (count >= FDSA_PTRVECTOR_PARALLEL_COPY)
+    {
+        fdsa_parallel_run(tasks, copyTask);
+    }
+    else
+    {
+        for (i = 0; i < tasks; ++i)
+        {
+            copyTask(i);
+        }
+    }
+
+    if (failed.load(std::memory_order_relaxed))
+    {
+        for (i = first; i < amount; ++i)
+        {
+            if (data[i] && vec->freeFunc) vec->freeFunc(data[i]);
         }
+
+        return fdsa_failed;
+    }
+
+    vec->size = amount;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_swapRemove(fdsa_ptrVector *vec,
+                                                  size_t index)
+{
+    if (!vec)
+    {
+        return fdsa_failed;
+    }
+
+    std::unique_lock<std::mutex> lock(vec->mutex);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    void *removed = vec->data[index];
+    --vec->size;
+    vec->data[index] = vec->data[vec->size];
+    fdsa_ptrVector_trimInternal(vec);
+
+    fdsa_freeFunc freeFunc = vec->freeFunc;
+    lock.unlock();
+    if (freeFunc) freeFunc(removed);
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_eraseAt(fdsa_ptrVector *vec,
+                                               size_t index)
+{
+    if (!vec)
+    {
+        return fdsa_failed;
+    }
+
+    std::unique_lock<std::mutex> lock(vec->mutex);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    void *removed = vec->data[index];
+    --vec->size;
+    memmove(vec->data + index, vec->data + index + 1,
+            (vec->size - index) * sizeof(uint8_t *));
+    fdsa_ptrVector_trimInternal(vec);
+
+    fdsa_freeFunc freeFunc = vec->freeFunc;
+    lock.unlock();
+    if (freeFunc) freeFunc(removed);
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_eraseRange(fdsa_ptrVector *vec,
+                                                  size_t first,
+                                                  size_t count)
+{
+    if (!vec)
+    {
+        return fdsa_failed;
+    }
+
+    std::unique_lock<std::mutex> lock(vec->mutex);
+    if (first > vec->size || count > vec->size - first)
+    {
+        return fdsa_failed;
+    }
+
+    if (!count)
+    {
+        // do nothing
+        return fdsa_success;
+    }
+
+    uint8_t **removed = fdsa_ptrVector_detachInternal(vec,
+                                                      vec->data + first,
+                                                      count);
+    memmove(vec->data + first, vec->data + first + count,
+            (vec->size - first - count) * sizeof(uint8_t *));
+    vec->size -= count;
+    fdsa_ptrVector_trimInternal(vec);
+
+    fdsa_ptrVector_releaseInternal(vec, lock, removed, count);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_removeIf(fdsa_ptrVector *vec,
+                                                fdsa_ptrVector_predFunc pred,
+                                                void *ctx,
+                                                size_t *removed)
+{
+    if (!vec || !pred)
+    {
+        return fdsa_failed;
     }
 
+    std::unique_lock<std::mutex> lock(vec->mutex);
+    uint8_t **data = vec->data;
+    size_t size = vec->size;
+
+    // Swap every kept pointer down, the removed ones collect in
+    // [kept, size) in some order while the kept ones stay in order.
+    size_t kept = 0;
     size_t i;
-    if (vec->size > amount)
+    for (i = 0; i < size; ++i)
     {
-        std::lock_guard<std::mutex> lock(vec->mutex);
-        for (i = amount; i < vec->size; ++i)
+        if (pred(data[i], ctx))
         {
-            vec->freeFunc(vec->data[i]);
-            vec->data[i] = NULL;
+            continue;
         }
 
-        vec->size = amount;
+        if (i != kept)
+        {
+            uint8_t *tmp = data[kept];
+            data[kept] = data[i];
+            data[i] = tmp;
+        }
+
+        ++kept;
+    }
+
+    size_t count = size - kept;
+    if (removed) *removed = count;
+    if (!count)
+    {
+        return fdsa_success;
+    }
+
+    uint8_t **tail = fdsa_ptrVector_detachInternal(vec, data + kept, count);
+    vec->size = kept;
+    fdsa_ptrVector_trimInternal(vec);
+
+    fdsa_ptrVector_releaseInternal(vec, lock, tail, count);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_forEach(fdsa_ptrVector *vec,
+                                               fdsa_ptrVector_visitFunc func,
+                                               void *ctx,
+                                               size_t prefetchDistance)
+{
+    if (!vec || !func)
+    {
+        return fdsa_failed;
     }
-    else if (vec->size < amount)
+
+    std::lock_guard<std::mutex> lock(vec->mutex);
+    uint8_t **data = vec->data;
+    size_t size = vec->size;
+    size_t i = 0;
+    if (prefetchDistance && prefetchDistance < size)
     {
-        // vec->capacity >= amount
+        // warm up the window, then keep it prefetchDistance ahead
+        for (i = 0; i < prefetchDistance; ++i)
+        {
+            FDSA_PREFETCH(data[i]);
+        }
 
-        void *toBeInsert = NULL;
-        for (i = vec->size; i < amount; ++i)
+        for (i = 0; i < size - prefetchDistance; ++i)
         {
-            toBeInsert = deepCopyFunc(src);
-            if (!toBeInsert)
+            FDSA_PREFETCH(data[i + prefetchDistance]);
+            if (func(data[i], i, ctx))
             {
-                return fdsa_failed;
+                return fdsa_success;
             }
+        }
+    }
 
-            if (fdsa_ptrVector_pushBack(vec, toBeInsert) == fdsa_failed)
-            {
-                return fdsa_failed;
-            }
+    for (; i < size; ++i)
+    {
+        if (func(data[i], i, ctx))
+        {
+            return fdsa_success;
         }
     }
 
     return fdsa_success;
 }
 
+FDSA_API fdsa_exitstate fdsa_ptrVector_shrinkToFit(fdsa_ptrVector *vec)
+{
+    if (!vec)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<std::mutex> lock(vec->mutex);
+    if (vec->size == vec->capacity)
+    {
+        // do nothing
+        return fdsa_success;
+    }
+
+    return fdsa_ptrVector_reallocInternal(vec, vec->size);
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_setTrimPolicy(fdsa_ptrVector *vec,
+                                                     double threshold,
+                                                     size_t minCapacity)
+{
+    if (!vec || (threshold != 0.0 && !(threshold > 2.0)))
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<std::mutex> lock(vec->mutex);
+    vec->trimThreshold = threshold;
+    vec->trimMinCapacity = minCapacity;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_setReclaimMode(fdsa_ptrVector *vec,
+                                                      unsigned mode)
+{
+    if (!vec || mode > fdsa_ptrVector_reclaimDeferred)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<std::mutex> lock(vec->mutex);
+    vec->reclaimMode = mode;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_ptrVector_flush(fdsa_ptrVector *vec)
+{
+    uint64_t ticket;
+    if (vec)
+    {
+        std::lock_guard<std::mutex> lock(vec->mutex);
+        ticket = vec->reclaimTicket;
+    }
+    else
+    {
+        ticket = fdsa_reclaimer_lastTicket();
+    }
+
+    // wait outside of the lock, the vector stays usable meanwhile
+    fdsa_reclaimer_wait(ticket);
+    return fdsa_success;
+}
+
 } // end extern "C"
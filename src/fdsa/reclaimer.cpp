@@ -0,0 +1,302 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "parallel.h"
+#include "reclaimer.h"
+
+// below this many pointers a single thread is faster than a fork-join
+#define FDSA_RECLAIMER_PARALLEL_MIN 65536
+
+#define FDSA_RECLAIMER_CHUNK 16384
+
+typedef struct fdsa_reclaimBatch
+{
+    uint8_t **data;
+
+    size_t size;
+
+    fdsa_freeFunc freeFunc;
+} fdsa_reclaimBatch;
+
+// The background reclaimer, one per process. The object is never
+// destroyed, so that vectors destroyed during static teardown can still
+// reach it. The thread is drained and joined when the library is
+// unloaded or the process exits, later batches are released inline.
+typedef struct fdsa_reclaimer
+{
+    std::mutex mutex;
+
+    std::condition_variable pending;
+
+    std::condition_variable done;
+
+    std::deque<fdsa_reclaimBatch> queue;
+
+    uint64_t queued = 0;
+
+    uint64_t released = 0; // batches are released in ticket order
+
+    std::thread::id releaser; // the thread releasing the front batch
+
+    std::thread thread; // started on first push
+
+    bool stopping = false; // set at exit, no batch is queued after it
+} fdsa_reclaimer;
+
+static std::atomic<fdsa_reclaimer *> fdsa_reclaimer_created{NULL};
+
+#ifndef _WIN32
+static void fdsa_reclaimer_forkPrepare()
+{
+    fdsa_reclaimer_created.load()->mutex.lock();
+}
+
+static void fdsa_reclaimer_forkParent()
+{
+    fdsa_reclaimer_created.load()->mutex.unlock();
+}
+
+// Only the forking thread exists in the child. The copied thread handle
+// is dropped and the next push starts a new thread, the condition
+// variables may still count the parent's waiters. A batch another thread
+// was releasing cannot be finished, the rest of it leaks in the child.
+static void fdsa_reclaimer_forkChild()
+{
+    fdsa_reclaimer *reclaimer = fdsa_reclaimer_created.load();
+    if (reclaimer->releaser != std::thread::id() &&
+        reclaimer->releaser != std::this_thread::get_id())
+    {
+        reclaimer->releaser = std::thread::id();
+        ++reclaimer->released;
+    }
+
+    new (&reclaimer->thread) std::thread;
+    new (&reclaimer->pending) std::condition_variable;
+    new (&reclaimer->done) std::condition_variable;
+    reclaimer->mutex.unlock();
+}
+#endif
+
+// NULL only if the reclaimer could not be allocated
+static fdsa_reclaimer *fdsa_reclaimer_instance()
+{
+    static fdsa_reclaimer *ret = []()
+    {
+        fdsa_reclaimer *reclaimer = new (std::nothrow) fdsa_reclaimer;
+        if (reclaimer)
+        {
+            fdsa_reclaimer_created.store(reclaimer);
+#ifndef _WIN32
+            pthread_atfork(fdsa_reclaimer_forkPrepare,
+                           fdsa_reclaimer_forkParent,
+                           fdsa_reclaimer_forkChild);
+#endif
+        }
+
+        return reclaimer;
+    }();
+
+    return ret;
+}
+
+// Release the queued batches on the calling thread.
+// lock holds reclaimer->mutex
+static void fdsa_reclaimer_drain(fdsa_reclaimer *reclaimer,
+                                 std::unique_lock<std::mutex> &lock)
+{
+    while (!reclaimer->queue.empty())
+    {
+        fdsa_reclaimBatch batch = reclaimer->queue.front();
+        reclaimer->queue.pop_front();
+        reclaimer->releaser = std::this_thread::get_id();
+        lock.unlock();
+
+        // the reclaimer is off the caller's path, one thread is enough
+        fdsa_reclaimer_release(batch.data, batch.size, batch.freeFunc, false);
+
+        lock.lock();
+        reclaimer->releaser = std::thread::id();
+        ++reclaimer->released;
+        reclaimer->done.notify_all();
+    }
+}
+
+static void fdsa_reclaimer_run(fdsa_reclaimer *reclaimer)
+{
+    std::unique_lock<std::mutex> lock(reclaimer->mutex);
+    while (!reclaimer->stopping || !reclaimer->queue.empty())
+    {
+        reclaimer->pending.wait(lock, [&]()
+        {
+            return reclaimer->stopping || !reclaimer->queue.empty();
+        });
+
+        fdsa_reclaimer_drain(reclaimer, lock);
+    }
+}
+
+// Drain and join the thread before the library code goes away,
+// at exit() or dlclose().
+static struct fdsa_reclaimerShutdown
+{
+    ~fdsa_reclaimerShutdown()
+    {
+        fdsa_reclaimer *reclaimer = fdsa_reclaimer_created.load();
+        if (!reclaimer) return;
+
+        std::unique_lock<std::mutex> lock(reclaimer->mutex);
+        std::thread thread = std::move(reclaimer->thread);
+        reclaimer->stopping = true;
+        reclaimer->pending.notify_one();
+        lock.unlock();
+
+        if (thread.joinable())
+        {
+            // a freeFunc that calls exit() runs on the thread itself
+            if (thread.get_id() == std::this_thread::get_id())
+            {
+                thread.detach();
+            }
+            else
+            {
+                thread.join();
+            }
+        }
+
+        // the thread may be gone already, as on Windows at exit
+        lock.lock();
+        fdsa_reclaimer_drain(reclaimer, lock);
+    }
+} fdsa_reclaimer_shutdown;
+
+void fdsa_reclaimer_release(uint8_t **data,
+                            size_t size,
+                            fdsa_freeFunc freeFunc,
+                            bool parallel)
+{
+    if (freeFunc)
+    {
+        if (parallel && size >= FDSA_RECLAIMER_PARALLEL_MIN)
+        {
+            size_t chunk = FDSA_RECLAIMER_CHUNK;
+            fdsa_parallel_run((size + chunk - 1) / chunk, [&](size_t task)
+            {
+                size_t end = (task + 1) * chunk;
+                if (end > size) end = size;
+
+                size_t i;
+                for (i = task * chunk; i < end; ++i)
+                {
+                    if (data[i]) freeFunc(data[i]);
+                }
+            });
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < size; ++i)
+            {
+                if (data[i]) freeFunc(data[i]);
+            }
+        }
+    }
+
+    delete[] data;
+}
+
+fdsa_exitstate fdsa_reclaimer_push(uint8_t **data,
+                                   size_t size,
+                                   fdsa_freeFunc freeFunc,
+                                   uint64_t *ticket)
+{
+    fdsa_reclaimer *reclaimer = fdsa_reclaimer_instance();
+    if (!reclaimer)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<std::mutex> lock(reclaimer->mutex);
+    if (reclaimer->stopping)
+    {
+        return fdsa_failed;
+    }
+
+    try
+    {
+        if (!reclaimer->thread.joinable())
+        {
+            reclaimer->thread = std::thread(fdsa_reclaimer_run, reclaimer);
+        }
+
+        reclaimer->queue.push_back({data, size, freeFunc});
+    }
+    catch (...)
+    {
+        return fdsa_failed;
+    }
+
+    *ticket = ++reclaimer->queued;
+    reclaimer->pending.notify_one();
+    return fdsa_success;
+}
+
+void fdsa_reclaimer_wait(uint64_t ticket)
+{
+    if (!ticket) return;
+
+    // a ticket was handed out, so the reclaimer exists
+    fdsa_reclaimer *reclaimer = fdsa_reclaimer_instance();
+    std::unique_lock<std::mutex> lock(reclaimer->mutex);
+
+    // a forked child has no thread until its first push
+    if (!reclaimer->thread.joinable() && !reclaimer->stopping)
+    {
+        fdsa_reclaimer_drain(reclaimer, lock);
+    }
+
+    reclaimer->done.wait(lock, [&]()
+    {
+        return reclaimer->released >= ticket;
+    });
+}
+
+uint64_t fdsa_reclaimer_lastTicket()
+{
+    fdsa_reclaimer *reclaimer = fdsa_reclaimer_instance();
+    if (!reclaimer) return 0;
+
+    std::lock_guard<std::mutex> lock(reclaimer->mutex);
+    return reclaimer->queued;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "include/internal/defines.h"
+
+// Release of pointer arrays taken out of a container, see
+// fdsa_ptrVector_setReclaimMode.
+
+// Call freeFunc on every non-NULL pointer of data, on worker threads if
+// there are many of them, then delete[] data. freeFunc may be NULL.
+void fdsa_reclaimer_release(uint8_t **data,
+                            size_t size,
+                            fdsa_freeFunc freeFunc,
+                            bool parallel);
+
+// Queue data for fdsa_reclaimer_release on the background reclaimer
+// thread, which is started on first use and drained and joined at exit.
+// *ticket identifies the batch for fdsa_reclaimer_wait. On failure,
+// which includes every call once exit started, nothing is queued.
+fdsa_exitstate fdsa_reclaimer_push(uint8_t **data,
+                                   size_t size,
+                                   fdsa_freeFunc freeFunc,
+                                   uint64_t *ticket);
+
+// Block until every batch up to ticket is released,
+// 0 never blocks.
+void fdsa_reclaimer_wait(uint64_t ticket);
+
+// The ticket of the last queued batch.
+uint64_t fdsa_reclaimer_lastTicket();
@@ -0,0 +1,75 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Segmented storage index helpers.
+// Segment k holds (base << k) elements, where base is a power of two,
+// so the element index i lives in segment log2(i / base + 1).
+// A directory of FDSA_SEGMENT_MAX entries covers any index of size_t,
+// and no segment is ever moved once allocated.
+
+#define FDSA_SEGMENT_MAX 64
+
+static inline unsigned fdsa_segment_log2(size_t in)
+{
+#ifdef _MSC_VER
+    unsigned long ret;
+    _BitScanReverse64(&ret, static_cast<unsigned long long>(in));
+    return static_cast<unsigned>(ret);
+#else
+    return static_cast<unsigned>(63 - __builtin_clzll(
+        static_cast<unsigned long long>(in)));
+#endif
+}
+
+// segment that holds index, baseShift is log2(base)
+static inline unsigned fdsa_segment_of(size_t index, unsigned baseShift)
+{
+    return fdsa_segment_log2((index >> baseShift) + 1);
+}
+
+// first index stored in segment
+static inline size_t fdsa_segment_begin(unsigned segment, unsigned baseShift)
+{
+    return ((static_cast<size_t>(1) << segment) - 1) << baseShift;
+}
+
+// number of elements stored in segment
+static inline size_t fdsa_segment_length(unsigned segment, unsigned baseShift)
+{
+    return static_cast<size_t>(1) << (segment + baseShift);
+}
+
+// number of segments usable without overflowing size_t
+static inline unsigned fdsa_segment_count(unsigned baseShift)
+{
+    return FDSA_SEGMENT_MAX - baseShift - 1;
+}
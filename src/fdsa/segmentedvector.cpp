@@ -0,0 +1,498 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "lock.h"
+#include "segment.h"
+#include "segmentedvector.h"
+#include "vectorkernel.h"
+
+#include "include/internal/vector.h"
+
+typedef struct fdsa_segmentedVector
+{
+    uint8_t *segments[FDSA_SEGMENT_MAX] = {};
+
+    size_t segmentCount = 0; // allocated segments
+
+    unsigned baseShift = 0; // the first segment holds 1 << baseShift elements
+
+    size_t sizeOfData = 0;
+
+    fdsa_vector_copyKernel copyElement = fdsa_vector_copyGeneric;
+
+    size_t size = 0;
+
+    size_t capacity = 0;
+
+    fdsa_lock lock;
+} fdsa_segmentedVector;
+
+// Call func(pointer, count) for each segment piece of [first, first + count)
+// caller must hold vec->lock
+template<typename Func>
+static void fdsa_segmentedVector_forEachPiece(fdsa_segmentedVector *vec,
+                                              size_t first,
+                                              size_t count,
+                                              Func func)
+{
+    while (count)
+    {
+        unsigned seg = fdsa_segment_of(first, vec->baseShift);
+        size_t offset = first - fdsa_segment_begin(seg, vec->baseShift);
+        size_t length = fdsa_segment_length(seg, vec->baseShift) - offset;
+        if (length > count)
+        {
+            length = count;
+        }
+
+        func(vec->segments[seg] + (offset * vec->sizeOfData), length);
+        first += length;
+        count -= length;
+    }
+}
+
+// caller must hold vec->lock
+static uint8_t *fdsa_segmentedVector_element(fdsa_segmentedVector *vec,
+                                             size_t index)
+{
+    unsigned seg = fdsa_segment_of(index, vec->baseShift);
+    size_t offset = index - fdsa_segment_begin(seg, vec->baseShift);
+    return vec->segments[seg] + (offset * vec->sizeOfData);
+}
+
+// Allocate segments until newSize elements fit, nothing is moved.
+// caller must hold vec->lock
+static fdsa_exitstate fdsa_segmentedVector_reserveInternal(
+        fdsa_segmentedVector *vec,
+        size_t newSize)
+{
+    while (vec->capacity < newSize)
+    {
+        if (vec->segmentCount >= fdsa_segment_count(vec->baseShift))
+        {
+            return fdsa_failed;
+        }
+
+        size_t length = fdsa_segment_length(
+            static_cast<unsigned>(vec->segmentCount), vec->baseShift);
+        if (length > SIZE_MAX / vec->sizeOfData)
+        {
+            return fdsa_failed;
+        }
+
+        uint8_t *seg = static_cast<uint8_t *>(
+            malloc(length * vec->sizeOfData));
+        if (!seg)
+        {
+            return fdsa_failed;
+        }
+
+        vec->segments[vec->segmentCount] = seg;
+        ++vec->segmentCount;
+        vec->capacity += length;
+    }
+
+    return fdsa_success;
+}
+
+extern "C"
+{
+
+fdsa_exitstate fdsa_segmentedVector_init(fdsa_segmentedVector_api *ret)
+{
+    if (!ret) return fdsa_failed;
+
+    ret->create = fdsa_segmentedVector_create;
+    ret->createEx = fdsa_segmentedVector_createEx;
+    ret->destory = fdsa_segmentedVector_destroy;
+    ret->at = fdsa_segmentedVector_at;
+    ret->setValue = fdsa_segmentedVector_setValue;
+    ret->atRange = fdsa_segmentedVector_atRange;
+    ret->setRange = fdsa_segmentedVector_setRange;
+    ret->clear = fdsa_segmentedVector_clear;
+    ret->size = fdsa_segmentedVector_size;
+    ret->capacity = fdsa_segmentedVector_capacity;
+    ret->reserve = fdsa_segmentedVector_reserve;
+    ret->pushBack = fdsa_segmentedVector_pushBack;
+    ret->resize = fdsa_segmentedVector_resize;
+    ret->append = fdsa_segmentedVector_append;
+    ret->address = fdsa_segmentedVector_address;
+    ret->segmentCount = fdsa_segmentedVector_segmentCount;
+    ret->segment = fdsa_segmentedVector_segment;
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_segmentedVector *fdsa_segmentedVector_create(size_t sizeOfData)
+{
+    return fdsa_segmentedVector_createEx(sizeOfData, fdsa_vector_lockMutex);
+}
+
+FDSA_API fdsa_segmentedVector *fdsa_segmentedVector_createEx(
+        size_t sizeOfData,
+        unsigned flags)
+{
+    if (!sizeOfData || (flags & ~fdsa_vector_lockMask))
+    {
+        return NULL;
+    }
+
+    fdsa_lockPolicy policy;
+    if (fdsa_lock_policyFromFlags(flags, &policy) == fdsa_failed)
+    {
+        return NULL;
+    }
+
+    fdsa_segmentedVector *vec = new (std::nothrow) fdsa_segmentedVector;
+    if (!vec)
+    {
+        return NULL;
+    }
+
+    // the first segment holds at least 1 KiB, or 16 elements
+    vec->baseShift = 4;
+    while (vec->baseShift < 16 &&
+           (static_cast<size_t>(1) << vec->baseShift) * sizeOfData < 1024)
+    {
+        ++vec->baseShift;
+    }
+
+    vec->sizeOfData = sizeOfData;
+    vec->copyElement = fdsa_vector_selectCopy(sizeOfData);
+    vec->lock.policy = policy;
+    return vec;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_destroy(
+        fdsa_segmentedVector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    vec->lock.lock();
+    size_t i;
+    for (i = 0; i < vec->segmentCount; ++i)
+    {
+        free(vec->segments[i]);
+    }
+
+    vec->lock.unlock();
+    delete vec;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_at(fdsa_segmentedVector *vec,
+                                                size_t index,
+                                                void *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    vec->copyElement(static_cast<uint8_t *>(dst),
+                     fdsa_segmentedVector_element(vec, index),
+                     vec->sizeOfData);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_setValue(
+        fdsa_segmentedVector *vec,
+        size_t index,
+        const void *src)
+{
+    if (!vec || !src)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    vec->copyElement(fdsa_segmentedVector_element(vec, index),
+                     static_cast<const uint8_t *>(src),
+                     vec->sizeOfData);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_atRange(
+        fdsa_segmentedVector *vec,
+        size_t first,
+        size_t count,
+        void *dst)
+{
+    if (!vec || !dst || !count)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (first >= vec->size || count > vec->size - first)
+    {
+        return fdsa_failed;
+    }
+
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    size_t sizeOfData = vec->sizeOfData;
+    fdsa_segmentedVector_forEachPiece(vec, first, count,
+                                      [&](uint8_t *piece, size_t length)
+    {
+        memcpy(out, piece, length * sizeOfData);
+        out += length * sizeOfData;
+    });
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_setRange(
+        fdsa_segmentedVector *vec,
+        size_t first,
+        size_t count,
+        const void *src)
+{
+    if (!vec || !src || !count)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (first >= vec->size || count > vec->size - first)
+    {
+        return fdsa_failed;
+    }
+
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    size_t sizeOfData = vec->sizeOfData;
+    fdsa_segmentedVector_forEachPiece(vec, first, count,
+                                      [&](uint8_t *piece, size_t length)
+    {
+        memcpy(piece, in, length * sizeOfData);
+        in += length * sizeOfData;
+    });
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_clear(fdsa_segmentedVector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    vec->size = 0;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_size(fdsa_segmentedVector *vec,
+                                                  size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = vec->size;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_capacity(
+        fdsa_segmentedVector *vec,
+        size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = vec->capacity;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_reserve(
+        fdsa_segmentedVector *vec,
+        size_t newSize)
+{
+    if (!vec) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    return fdsa_segmentedVector_reserveInternal(vec, newSize);
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_pushBack(
+        fdsa_segmentedVector *vec,
+        const void *src)
+{
+    if (!vec || !src)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (vec->size == vec->capacity)
+    {
+        if (fdsa_segmentedVector_reserveInternal(vec, vec->size + 1) ==
+            fdsa_failed)
+        {
+            return fdsa_failed;
+        }
+    }
+
+    vec->copyElement(fdsa_segmentedVector_element(vec, vec->size),
+                     static_cast<const uint8_t *>(src),
+                     vec->sizeOfData);
+    ++vec->size;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_resize(
+        fdsa_segmentedVector *vec,
+        size_t amount,
+        const void *src)
+{
+    if (!vec || !src)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_segmentedVector_reserveInternal(vec, amount) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    if (amount > vec->size)
+    {
+        size_t sizeOfData = vec->sizeOfData;
+        fdsa_segmentedVector_forEachPiece(vec, vec->size, amount - vec->size,
+                                          [&](uint8_t *piece, size_t length)
+        {
+            fdsa_vector_patternFill(piece,
+                                    static_cast<const uint8_t *>(src),
+                                    length,
+                                    sizeOfData);
+        });
+    }
+
+    vec->size = amount;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_append(
+        fdsa_segmentedVector *vec,
+        const void *in,
+        size_t inLen)
+{
+    if (!vec || !in || !inLen) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (inLen > SIZE_MAX - vec->size ||
+        fdsa_segmentedVector_reserveInternal(vec, vec->size + inLen) ==
+        fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(in);
+    size_t sizeOfData = vec->sizeOfData;
+    fdsa_segmentedVector_forEachPiece(vec, vec->size, inLen,
+                                      [&](uint8_t *piece, size_t length)
+    {
+        memcpy(piece, src, length * sizeOfData);
+        src += length * sizeOfData;
+    });
+
+    vec->size += inLen;
+    return fdsa_success;
+}
+
+FDSA_API void *fdsa_segmentedVector_address(fdsa_segmentedVector *vec,
+                                            size_t index)
+{
+    if (!vec) return NULL;
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (index >= vec->size)
+    {
+        return NULL;
+    }
+
+    return fdsa_segmentedVector_element(vec, index);
+}
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_segmentCount(
+        fdsa_segmentedVector *vec,
+        size_t *dst)
+{
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = vec->size ? fdsa_segment_of(vec->size - 1, vec->baseShift) + 1 : 0;
+    return fdsa_success;
+}
+
+FDSA_API const void *fdsa_segmentedVector_segment(
+        fdsa_segmentedVector *vec,
+        size_t segment,
+        size_t *length)
+{
+    if (!vec || !length)
+    {
+        return NULL;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (!vec->size ||
+        segment > fdsa_segment_of(vec->size - 1, vec->baseShift))
+    {
+        return NULL;
+    }
+
+    unsigned seg = static_cast<unsigned>(segment);
+    size_t begin = fdsa_segment_begin(seg, vec->baseShift);
+    size_t used = vec->size - begin;
+    size_t segLength = fdsa_segment_length(seg, vec->baseShift);
+    *length = (used < segLength) ? used : segLength;
+    return vec->segments[seg];
+}
+
+} // end extern "C"
@@ -0,0 +1,175 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fdsa.h"
+
+typedef struct Row
+{
+    uint64_t key;
+    uint16_t tag;
+    double value;
+} Row;
+
+int main()
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    fdsa_columnVector_api *vecApi = &api.columnVector;
+
+    size_t sizes[3] = {sizeof(uint64_t), sizeof(uint16_t), sizeof(double)};
+    size_t offsets[3] = {offsetof(Row, key),
+                         offsetof(Row, tag),
+                         offsetof(Row, value)};
+
+    if (vecApi->create(0, sizes, offsets) ||
+        vecApi->createEx(3, sizes, offsets, 0x10))
+    {
+        fputs("Invalid argument is accepted.\n", stderr);
+        return 1;
+    }
+
+    fdsa_columnVector *vec = vecApi->create(3, sizes, offsets);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return 1;
+    }
+
+    Row row;
+    memset(&row, 0, sizeof(Row));
+    size_t i;
+    for (i = 0; i < 5000; ++i)
+    {
+        row.key = i * 3;
+        row.tag = (uint16_t)(i & 0xff);
+        row.value = (double)i / 2;
+        if (vecApi->pushBack(vec, &row) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    size_t size = 0;
+    size_t capacity = 0;
+    size_t columns = 0;
+    if (vecApi->size(vec, &size) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed ||
+        vecApi->columnCount(vec, &columns) == fdsa_failed ||
+        size != 5000 || capacity < size || columns != 3)
+    {
+        fputs("Size mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    // every column is a contiguous, cache line aligned array
+    const uint64_t *keys = vecApi->columnData(vec, 0);
+    const uint16_t *tags = vecApi->columnData(vec, 1);
+    if (!keys || !tags || ((uintptr_t)keys & 63) ||
+        vecApi->columnData(vec, 3))
+    {
+        fputs("Fail to get column.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    for (i = 0; i < 5000; ++i)
+    {
+        if (keys[i] != i * 3 || tags[i] != (uint16_t)(i & 0xff) ||
+            vecApi->at(vec, i, &row) == fdsa_failed ||
+            row.key != i * 3 || row.value != (double)i / 2)
+        {
+            fputs("Data mismatch.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    double value = 0;
+    row.key = 7;
+    row.tag = 8;
+    row.value = 9;
+    if (vecApi->setValue(vec, 10, &row) == fdsa_failed ||
+        vecApi->setField(vec, 2, 11, &row.value) == fdsa_failed ||
+        vecApi->field(vec, 2, 11, &value) == fdsa_failed || value != 9 ||
+        vecApi->at(vec, 10, &row) == fdsa_failed ||
+        row.key != 7 || row.tag != 8 || row.value != 9 ||
+        vecApi->at(vec, 5000, &row) == fdsa_success ||
+        vecApi->field(vec, 3, 0, &value) == fdsa_success)
+    {
+        fputs("Fail to set value.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    if (vecApi->clear(vec) == fdsa_failed ||
+        vecApi->size(vec, &size) == fdsa_failed || size ||
+        vecApi->at(vec, 0, &row) == fdsa_success)
+    {
+        fputs("Fail to clear.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    if (vecApi->destory(vec) == fdsa_failed)
+    {
+        fputs("Fail to destory vector.\n", stderr);
+        return 1;
+    }
+
+    // packed rows without offsets
+    uint8_t packed[12];
+    uint8_t out[12];
+    size_t packedSizes[2] = {4, 8};
+    vec = vecApi->createEx(2, packedSizes, NULL, 1);
+    for (i = 0; i < sizeof(packed); ++i)
+    {
+        packed[i] = (uint8_t)i;
+    }
+
+    if (!vec || vecApi->reserve(vec, 100) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 100 ||
+        vecApi->pushBack(vec, packed) == fdsa_failed ||
+        vecApi->at(vec, 0, out) == fdsa_failed ||
+        memcmp(packed, out, sizeof(packed)) ||
+        memcmp(vecApi->columnData(vec, 1), packed + 4, 8))
+    {
+        fputs("Packed row mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    return (vecApi->destory(vec) == fdsa_failed);
+}
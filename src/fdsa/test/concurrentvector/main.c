@@ -0,0 +1,153 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2020-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+
+#include "fdsa.h"
+
+int main()
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    fdsa_concurrentVector_api *vecApi = &api.concurrentVector;
+
+    fdsa_concurrentVector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return 1;
+    }
+
+    // cross several segments
+    int data;
+    for (data = 0; data < 1000; ++data)
+    {
+        if (vecApi->pushBack(vec, &data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    // claim two slots and publish them out of order
+    size_t first = 0;
+    if (vecApi->claim(vec, 2, &first) == fdsa_failed || first != 1000)
+    {
+        fputs("Fail to claim.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    *(int *)vecApi->slot(vec, first + 1) = 1001;
+    if (vecApi->publish(vec, first + 1, 1) == fdsa_failed)
+    {
+        fputs("Fail to publish.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    size_t size = 0;
+    if (vecApi->size(vec, &size) == fdsa_failed || size != 1000 ||
+        vecApi->at(vec, 1001, &data) != fdsa_failed)
+    {
+        fputs("Unpublished slot is visible.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    *(int *)vecApi->slot(vec, first) = 1000;
+    if (vecApi->publish(vec, first, 1) == fdsa_failed ||
+        vecApi->size(vec, &size) == fdsa_failed || size != 1002)
+    {
+        fputs("Fail to publish.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    // a claim past the limit must not leave a hole that blocks committed
+    if (vecApi->claim(vec, (size_t)-1, &first) != fdsa_failed ||
+        vecApi->claim(vec, (size_t)-1 - 1000, &first) != fdsa_failed)
+    {
+        fputs("Oversized claim is accepted.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    int bulk[600];
+    for (data = 0; data < 600; ++data)
+    {
+        bulk[data] = 1002 + data;
+    }
+
+    if (vecApi->append(vec, bulk, 600) == fdsa_failed)
+    {
+        fputs("Fail to append.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    if (vecApi->size(vec, &size) == fdsa_failed || size != 1602)
+    {
+        fputs("Claim after a failed claim is not visible.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    fdsa_vector *flat = vecApi->toVector(vec);
+    if (!flat)
+    {
+        fputs("Fail to flatten.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    const int *flatData = api.vector.data(flat);
+    for (data = 0; data < 1602; ++data)
+    {
+        int value = -1;
+        if (vecApi->at(vec, (size_t)data, &value) == fdsa_failed ||
+            value != data || flatData[data] != data)
+        {
+            fputs("Data mismatch.\n", stderr);
+            api.vector.destory(flat);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    printf("size = %d\n", data);
+    if (api.vector.destory(flat) == fdsa_failed ||
+        vecApi->destory(vec) == fdsa_failed)
+    {
+        fputs("Fail to destory vector.\n", stderr);
+        return 1;
+    }
+
+    return 0;
+}
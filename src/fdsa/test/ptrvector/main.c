@@ -23,6 +23,11 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "fdsa.h"
 
@@ -100,6 +105,613 @@ fdsa_exitstate dumpData(fdsa_ptrVector_api *vecApi, fdsa_ptrVector *vec)
     return fdsa_success;
 }
 
+fdsa_exitstate testShrink(fdsa_ptrVector_api *vecApi)
+{
+    fdsa_ptrVector *vec = vecApi->create(freeTesting);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    if (vecApi->reserve(vec, 100) == fdsa_failed ||
+        vecApi->setTrimPolicy(vec, 4.0, 8) == fdsa_failed ||
+        vecApi->setTrimPolicy(vec, 1.5, 8) != fdsa_failed)
+    {
+        fputs("Fail to set up vector.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < 100; ++i)
+    {
+        Testing *data = createTesting();
+        if (!data || vecApi->pushBack(vec, data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            free(data);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        data->a = (int)i;
+    }
+
+    // 10 of 100 slots used, the policy leaves room for 20
+    size_t capacity = 0;
+    if (vecApi->resize(vec, 10, NULL, deepCopyTesting) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 20)
+    {
+        fputs("Trim policy does not apply on resize.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    Testing *data = vecApi->at(vec, 9);
+    if (vecApi->shrinkToFit(vec) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 10 ||
+        vecApi->at(vec, 9) != data || data->a != 9)
+    {
+        fputs("Fail to shrink to fit.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    if (vecApi->clear(vec) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 8)
+    {
+        fputs("Trim policy does not apply on clear.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testPushBackN(fdsa_ptrVector_api *vecApi)
+{
+    fdsa_ptrVector *vec = vecApi->create(freeTesting);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < 10000; ++i)
+    {
+        Testing *data = createTesting();
+        if (!data || vecApi->pushBack(vec, data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            free(data);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        data->a = (int)i;
+    }
+
+    // growth is geometric, not one slot at a time
+    size_t capacity = 0;
+    if (vecApi->capacity(vec, &capacity) == fdsa_failed ||
+        capacity < 10000 || capacity >= 20000)
+    {
+        fputs("Unexpected capacity.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    void *batch[5000];
+    for (i = 0; i < 5000; ++i)
+    {
+        Testing *data = createTesting();
+        if (!data)
+        {
+            fputs("Fail to allocate memory.\n", stderr);
+            while (i) free(batch[--i]);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        data->a = (int)(10000 + i);
+        batch[i] = data;
+    }
+
+    if (vecApi->pushBackN(vec, batch, 5000) == fdsa_failed)
+    {
+        fputs("Fail to pushback batch.\n", stderr);
+        for (i = 0; i < 5000; ++i) free(batch[i]);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    size_t size = 0;
+    if (vecApi->pushBackN(vec, NULL, 0) == fdsa_failed ||
+        vecApi->pushBackN(vec, NULL, 1) != fdsa_failed ||
+        vecApi->size(vec, &size) == fdsa_failed || size != 15000)
+    {
+        fputs("Size mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < 15000; ++i)
+    {
+        Testing *data = vecApi->at(vec, i);
+        if (!data || data->a != (int)i)
+        {
+            fputs("Data mismatch.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    return vecApi->destory(vec);
+}
+
+static int sumTesting(void *element, size_t index, void *ctx)
+{
+    int *sum = (int *)ctx;
+    Testing *data = (Testing *)element;
+    if (data->a != (int)index)
+    {
+        *sum = -1;
+        return 1;
+    }
+
+    *sum += data->a;
+
+    // stop after element 99
+    return (index == 99);
+}
+
+fdsa_exitstate testForEach(fdsa_ptrVector_api *vecApi)
+{
+    fdsa_ptrVector *vec = vecApi->create(freeTesting);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < 1000; ++i)
+    {
+        Testing *data = createTesting();
+        if (!data || vecApi->pushBack(vec, data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            free(data);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        data->a = (int)i;
+    }
+
+    // with and without prefetching, and a distance past the end
+    size_t distances[3] = {0, 8, 5000};
+    for (i = 0; i < 3; ++i)
+    {
+        int sum = 0;
+        if (vecApi->forEach(vec, sumTesting, &sum, distances[i]) ==
+            fdsa_failed || sum != 4950)
+        {
+            fputs("Fail to visit.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->forEach(vec, NULL, NULL, 0) != fdsa_failed)
+    {
+        fputs("Invalid argument is accepted.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+#define RECLAIM_COUNT 100000
+
+static char reclaimed[RECLAIM_COUNT];
+
+// elements are distinct, so concurrent calls touch distinct flags
+static void reclaimTesting(void *in)
+{
+    Testing *testing = (Testing *)in;
+    reclaimed[testing->a] = 1;
+    free(testing);
+}
+
+static fdsa_exitstate fillReclaim(fdsa_ptrVector_api *vecApi,
+                                  fdsa_ptrVector *vec)
+{
+    memset(reclaimed, 0, sizeof(reclaimed));
+
+    size_t i;
+    for (i = 0; i < RECLAIM_COUNT; ++i)
+    {
+        Testing *data = createTesting();
+        if (!data || vecApi->pushBack(vec, data) == fdsa_failed)
+        {
+            free(data);
+            return fdsa_failed;
+        }
+
+        data->a = (int)i;
+    }
+
+    return fdsa_success;
+}
+
+static size_t countReclaimed()
+{
+    size_t ret = 0;
+    size_t i;
+    for (i = 0; i < RECLAIM_COUNT; ++i)
+    {
+        ret += reclaimed[i];
+    }
+
+    return ret;
+}
+
+fdsa_exitstate testReclaim(fdsa_ptrVector_api *vecApi)
+{
+    fdsa_ptrVector *vec = vecApi->create(reclaimTesting);
+    if (!vec || vecApi->setReclaimMode(vec, 3) != fdsa_failed)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // parallel: everything is freed when clear returns
+    size_t size = 1;
+    size_t capacity = 1;
+    if (vecApi->setReclaimMode(vec, fdsa_ptrVector_reclaimParallel) ==
+        fdsa_failed ||
+        fillReclaim(vecApi, vec) == fdsa_failed ||
+        vecApi->clear(vec) == fdsa_failed ||
+        countReclaimed() != RECLAIM_COUNT ||
+        vecApi->size(vec, &size) == fdsa_failed || size ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity)
+    {
+        fputs("Fail to clear in parallel.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // deferred: everything is freed after flush
+    if (vecApi->setReclaimMode(vec, fdsa_ptrVector_reclaimDeferred) ==
+        fdsa_failed ||
+        fillReclaim(vecApi, vec) == fdsa_failed ||
+        vecApi->clear(vec) == fdsa_failed ||
+        vecApi->flush(vec) == fdsa_failed ||
+        countReclaimed() != RECLAIM_COUNT)
+    {
+        fputs("Fail to clear in background.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // the vector is usable right after a deferred clear
+    if (fillReclaim(vecApi, vec) == fdsa_failed ||
+        vecApi->destory(vec) == fdsa_failed ||
+        vecApi->flush(NULL) == fdsa_failed ||
+        countReclaimed() != RECLAIM_COUNT)
+    {
+        fputs("Fail to destory in background.\n", stderr);
+        return fdsa_failed;
+    }
+
+    return fdsa_success;
+}
+
+#if !defined(_WIN32) && !defined(__SANITIZE_THREAD__)
+#define RECLAIM_EXIT_COUNT 10
+
+static int reclaimPipe = -1;
+
+static void reclaimToPipe(void *in)
+{
+    char byte = 1;
+    if (write(reclaimPipe, &byte, 1) != 1)
+    {
+        abort();
+    }
+
+    free(in);
+}
+
+// a forked child runs its own reclaimer, and exit frees what is queued
+fdsa_exitstate testReclaimFork(fdsa_ptrVector_api *vecApi)
+{
+    int fds[2];
+    if (pipe(fds))
+    {
+        fputs("Fail to create pipe.\n", stderr);
+        return fdsa_failed;
+    }
+
+    fdsa_ptrVector *vec = vecApi->create(reclaimTesting);
+    if (!vec ||
+        vecApi->setReclaimMode(vec, fdsa_ptrVector_reclaimDeferred) ==
+        fdsa_failed ||
+        fillReclaim(vecApi, vec) == fdsa_failed ||
+        vecApi->clear(vec) == fdsa_failed)
+    {
+        fputs("Fail to clear in background.\n", stderr);
+        vecApi->destory(vec);
+        close(fds[0]);
+        close(fds[1]);
+        return fdsa_failed;
+    }
+
+    pid_t pid = fork();
+    if (!pid)
+    {
+        // the batch the parent was freeing during fork is lost here,
+        // flush has to return anyway
+        close(fds[0]);
+        if (vecApi->flush(NULL) == fdsa_failed)
+        {
+            _exit(1);
+        }
+
+        // no flush, exit frees the batch
+        reclaimPipe = fds[1];
+        fdsa_ptrVector *piped = vecApi->create(reclaimToPipe);
+        if (!piped ||
+            vecApi->setReclaimMode(piped, fdsa_ptrVector_reclaimDeferred) ==
+            fdsa_failed)
+        {
+            _exit(1);
+        }
+
+        int i;
+        for (i = 0; i < RECLAIM_EXIT_COUNT; ++i)
+        {
+            Testing *data = createTesting();
+            if (!data || vecApi->pushBack(piped, data) == fdsa_failed)
+            {
+                _exit(1);
+            }
+        }
+
+        vecApi->destory(piped);
+        exit(0);
+    }
+
+    close(fds[1]);
+    int freed = 0;
+    char byte;
+    while (pid > 0 && read(fds[0], &byte, 1) == 1)
+    {
+        ++freed;
+    }
+
+    close(fds[0]);
+    int status = 1;
+    if (pid > 0) waitpid(pid, &status, 0);
+    vecApi->flush(vec);
+    vecApi->destory(vec);
+    if (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) ||
+        freed != RECLAIM_EXIT_COUNT)
+    {
+        fputs("Fail to reclaim after fork or at exit.\n", stderr);
+        return fdsa_failed;
+    }
+
+    return fdsa_success;
+}
+#endif
+
+static int copyBudget;
+
+// single threaded only, used with small growths
+void *limitedCopyTesting(void *in)
+{
+    if (!copyBudget)
+    {
+        return NULL;
+    }
+
+    --copyBudget;
+    return deepCopyTesting(in);
+}
+
+fdsa_exitstate testResize(fdsa_ptrVector_api *vecApi)
+{
+    fdsa_ptrVector *vec = vecApi->create(freeTesting);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    Testing src = {7, 8};
+    size_t size = 0;
+    if (vecApi->resize(vec, 10, &src, deepCopyTesting) == fdsa_failed ||
+        vecApi->resize(vec, 20, &src, NULL) != fdsa_failed)
+    {
+        fputs("Fail to resize.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // the 6th copy fails, the 5 made before are freed
+    copyBudget = 5;
+    if (vecApi->resize(vec, 100, &src, limitedCopyTesting) != fdsa_failed ||
+        vecApi->size(vec, &size) == fdsa_failed || size != 10)
+    {
+        fputs("Fail to roll back.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // shrinking skips NULL slots, reclaimTesting would crash on them
+    fdsa_ptrVector *holes = vecApi->create(reclaimTesting);
+    if (!holes || fillReclaim(vecApi, holes) == fdsa_failed ||
+        vecApi->pushBack(holes, NULL) == fdsa_failed ||
+        vecApi->resize(holes, 10, NULL, NULL) == fdsa_failed ||
+        countReclaimed() != RECLAIM_COUNT - 10 ||
+        vecApi->size(holes, &size) == fdsa_failed || size != 10)
+    {
+        fputs("Fail to shrink over NULL slots.\n", stderr);
+        if (holes) vecApi->destory(holes);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(holes);
+
+    // large enough to copy on worker threads
+    if (vecApi->resize(vec, 100000, &src, deepCopyTesting) == fdsa_failed ||
+        vecApi->size(vec, &size) == fdsa_failed || size != 100000)
+    {
+        fputs("Fail to resize in parallel.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < size; ++i)
+    {
+        Testing *data = vecApi->at(vec, i);
+        if (!data || data == &src || data->a != 7 || data->b != 8)
+        {
+            fputs("Data mismatch.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    return vecApi->destory(vec);
+}
+
+static int isOdd(const void *element, void *ctx)
+{
+    (void)ctx;
+    return ((const Testing *)element)->a & 1;
+}
+
+static fdsa_exitstate checkOrder(fdsa_ptrVector_api *vecApi,
+                                 fdsa_ptrVector *vec,
+                                 const int *expected,
+                                 size_t count)
+{
+    size_t size = 0;
+    if (vecApi->size(vec, &size) == fdsa_failed || size != count)
+    {
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        Testing *data = vecApi->at(vec, i);
+        if (!data || data->a != expected[i])
+        {
+            return fdsa_failed;
+        }
+    }
+
+    return fdsa_success;
+}
+
+fdsa_exitstate testRemove(fdsa_ptrVector_api *vecApi)
+{
+    fdsa_ptrVector *vec = vecApi->create(freeTesting);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < 10; ++i)
+    {
+        Testing *data = createTesting();
+        if (!data || vecApi->pushBack(vec, data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            free(data);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        data->a = (int)i;
+    }
+
+    // 0 1 2 3 4 5 6 7 8 9 -> 0 9 2 3 4 5 6 7 8
+    int afterSwap[9] = {0, 9, 2, 3, 4, 5, 6, 7, 8};
+    if (vecApi->swapRemove(vec, 1) == fdsa_failed ||
+        vecApi->swapRemove(vec, 9) != fdsa_failed ||
+        checkOrder(vecApi, vec, afterSwap, 9) == fdsa_failed)
+    {
+        fputs("Fail to swap remove.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // -> 0 9 3 4 5 6 7 8 -> 0 9 3 7 8
+    int afterErase[5] = {0, 9, 3, 7, 8};
+    if (vecApi->eraseAt(vec, 2) == fdsa_failed ||
+        vecApi->eraseRange(vec, 3, 3) == fdsa_failed ||
+        vecApi->eraseRange(vec, 3, 3) != fdsa_failed ||
+        vecApi->eraseRange(vec, 5, 0) == fdsa_failed ||
+        checkOrder(vecApi, vec, afterErase, 5) == fdsa_failed)
+    {
+        fputs("Fail to erase.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // -> 0 8
+    int afterRemove[2] = {0, 8};
+    size_t removed = 0;
+    if (vecApi->removeIf(vec, isOdd, NULL, &removed) == fdsa_failed ||
+        removed != 3 ||
+        checkOrder(vecApi, vec, afterRemove, 2) == fdsa_failed ||
+        vecApi->removeIf(vec, isOdd, NULL, &removed) == fdsa_failed ||
+        removed != 0)
+    {
+        fputs("Fail to remove.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    if (vecApi->destory(vec) == fdsa_failed)
+    {
+        fputs("Fail to destory vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    // removed elements go to the reclaimer
+    vec = vecApi->create(reclaimTesting);
+    if (!vec ||
+        vecApi->setReclaimMode(vec, fdsa_ptrVector_reclaimDeferred) ==
+        fdsa_failed ||
+        fillReclaim(vecApi, vec) == fdsa_failed ||
+        vecApi->removeIf(vec, isOdd, NULL, &removed) == fdsa_failed ||
+        removed != RECLAIM_COUNT / 2 ||
+        vecApi->eraseRange(vec, 0, 10) == fdsa_failed ||
+        vecApi->flush(vec) == fdsa_failed ||
+        countReclaimed() != RECLAIM_COUNT / 2 + 10)
+    {
+        fputs("Fail to reclaim removed elements.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
 int main()
 {
     fDSA api;
@@ -361,5 +973,43 @@ int main()
         return 1;
     }
 
+    if (testShrink(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testPushBackN(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testForEach(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testReclaim(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    // ThreadSanitizer cannot follow a child that starts threads
+#if !defined(_WIN32) && !defined(__SANITIZE_THREAD__)
+    if (testReclaimFork(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+#endif
+
+    if (testResize(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testRemove(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
     return 0;
 }
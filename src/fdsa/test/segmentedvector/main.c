@@ -0,0 +1,149 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2020-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+
+#include "fdsa.h"
+
+int main()
+{
+    fDSA api;
+    if (fdsa_init(&api) == fdsa_failed)
+    {
+        fputs("Fail to create api entry.\n", stderr);
+        return 1;
+    }
+
+    fdsa_segmentedVector_api *vecApi = &api.segmentedVector;
+
+    fdsa_segmentedVector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return 1;
+    }
+
+    int data = 0;
+    if (vecApi->pushBack(vec, &data) == fdsa_failed)
+    {
+        fputs("Fail to pushback.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    // the address of the first element must survive growth
+    int *first = vecApi->address(vec, 0);
+    for (data = 1; data < 5000; ++data)
+    {
+        if (vecApi->pushBack(vec, &data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    int bulk[3000];
+    for (data = 0; data < 3000; ++data)
+    {
+        bulk[data] = 5000 + data;
+    }
+
+    if (vecApi->append(vec, bulk, 3000) == fdsa_failed ||
+        vecApi->resize(vec, 9000, &data) == fdsa_failed)
+    {
+        fputs("Fail to grow.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    if (first != vecApi->address(vec, 0))
+    {
+        fputs("Element is moved.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    for (data = 0; data < 9000; ++data)
+    {
+        int value = -1;
+        int expected = (data < 8000) ? data : 3000;
+        if (vecApi->at(vec, (size_t)data, &value) == fdsa_failed ||
+            value != expected)
+        {
+            fputs("Data mismatch.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+    }
+
+    // range access across segment boundaries
+    if (vecApi->atRange(vec, 100, 3000, bulk) == fdsa_failed ||
+        bulk[0] != 100 || bulk[2999] != 3099)
+    {
+        fputs("Fail to get range.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    // a streaming scan through the segments sees every element once
+    size_t segments = 0;
+    size_t seen = 0;
+    size_t i;
+    if (vecApi->segmentCount(vec, &segments) == fdsa_failed)
+    {
+        fputs("Fail to get segment count.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    for (i = 0; i < segments; ++i)
+    {
+        size_t length = 0;
+        const int *seg = vecApi->segment(vec, i, &length);
+        if (!seg || seg[0] != (seen < 8000 ? (int)seen : 3000))
+        {
+            fputs("Segment mismatch.\n", stderr);
+            vecApi->destory(vec);
+            return 1;
+        }
+
+        seen += length;
+    }
+
+    printf("segments = %zu, elements = %zu\n", segments, seen);
+    if (seen != 9000)
+    {
+        fputs("Segment scan mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return 1;
+    }
+
+    if (vecApi->destory(vec) == fdsa_failed)
+    {
+        fputs("Fail to destory vector.\n", stderr);
+        return 1;
+    }
+
+    return 0;
+}
@@ -21,36 +21,1374 @@
  * SOFTWARE.
  */
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "fdsa.h"
+
+fdsa_exitstate dumpData(fdsa_vector_api *vecApi, fdsa_vector *vec)
+{
+    size_t size = 0;
+    if (vecApi->size(vec, &size) == fdsa_failed)
+    {
+        fputs("Fail to get size.", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i = 0;
+    int data = 0;
+    for (i = 0; i < size; ++i)
+    {
+        if (vecApi->at(vec, i, &data) == fdsa_failed)
+        {
+            fputs("Fail to get value.", stderr);
+            return fdsa_failed;
+        }
+
+        printf("%d ", data);
+    }
+
+    printf("\n");
+    return fdsa_success;
+}
+
+fdsa_exitstate testGrowth(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    if (vecApi->setGrowthPolicy(vec, 1.5, 8, 4096) == fdsa_failed)
+    {
+        fputs("Fail to set growth policy.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    size_t capacity = 0;
+    size_t lastCapacity = 0;
+    size_t growCount = 0;
+    int i;
+    for (i = 0; i < 10000; ++i)
+    {
+        if (vecApi->pushBack(vec, &i) == fdsa_failed ||
+            vecApi->capacity(vec, &capacity) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        if (capacity != lastCapacity)
+        {
+            ++growCount;
+            lastCapacity = capacity;
+        }
+    }
+
+    int bulk[1000];
+    for (i = 0; i < 1000; ++i)
+    {
+        bulk[i] = 10000 + i;
+    }
+
+    if (vecApi->append(vec, bulk, 1000) == fdsa_failed)
+    {
+        fputs("Fail to append.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    int data = 0;
+    for (i = 0; i < 11000; ++i)
+    {
+        if (vecApi->at(vec, (size_t)i, &data) == fdsa_failed || data != i)
+        {
+            fputs("Data mismatch after growth.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    printf("Growth: %zu reallocations for 10000 pushBack\n", growCount);
+    if (growCount > 32)
+    {
+        fputs("Growth is not geometric.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    if (vecApi->setGrowthPolicy(vec, 0.5, 8, 0) != fdsa_failed)
+    {
+        fputs("Invalid growth policy is accepted.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testLockPolicy(fdsa_vector_api *vecApi)
+{
+    const unsigned flags[] =
+    {
+        fdsa_vector_lockMutex,
+        fdsa_vector_lockNone,
+        fdsa_vector_lockSpin,
+        fdsa_vector_lockShared
+    };
+
+    size_t i;
+    for (i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i)
+    {
+        fdsa_vector *vec = vecApi->createEx(sizeof(int), flags[i]);
+        if (!vec)
+        {
+            fputs("Fail to create vector.\n", stderr);
+            return fdsa_failed;
+        }
+
+        int j;
+        for (j = 0; j < 100; ++j)
+        {
+            if (vecApi->pushBack(vec, &j) == fdsa_failed)
+            {
+                fputs("Fail to pushback.\n", stderr);
+                vecApi->destory(vec);
+                return fdsa_failed;
+            }
+        }
+
+        size_t size = 0;
+        int data = 0;
+        if (vecApi->size(vec, &size) == fdsa_failed || size != 100 ||
+            vecApi->at(vec, 99, &data) == fdsa_failed || data != 99)
+        {
+            fputs("Data mismatch with lock policy.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        if (vecApi->destory(vec) == fdsa_failed)
+        {
+            fputs("Fail to destory vector.\n", stderr);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->createEx(sizeof(int), 0x80000000u))
+    {
+        fputs("Unknown flag is accepted.\n", stderr);
+        return fdsa_failed;
+    }
+
+    return fdsa_success;
+}
+
+fdsa_exitstate testRange(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    int in[64];
+    int out[64];
+    int i;
+    for (i = 0; i < 64; ++i)
+    {
+        in[i] = i;
+    }
+
+    if (vecApi->append(vec, in, 64) == fdsa_failed)
+    {
+        fputs("Fail to append.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < 16; ++i)
+    {
+        in[i] = -i;
+    }
+
+    if (vecApi->setRange(vec, 8, 16, in) == fdsa_failed ||
+        vecApi->atRange(vec, 0, 64, out) == fdsa_failed)
+    {
+        fputs("Fail to access range.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < 64; ++i)
+    {
+        int expected = (i >= 8 && i < 24) ? -(i - 8) : i;
+        if (out[i] != expected)
+        {
+            fputs("Data mismatch in range.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->atRange(vec, 60, 5, out) != fdsa_failed)
+    {
+        fputs("Out of range access is accepted.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testFill(fdsa_vector_api *vecApi)
+{
+    // power-of-two and odd element sizes take different fill paths
+    const size_t sizes[] = {1, 4, 16, 32, 3, 12, 40};
+    unsigned char element[40];
+    unsigned char out[40];
+    size_t i, j;
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        fdsa_vector *vec = vecApi->create(sizes[i]);
+        if (!vec)
+        {
+            fputs("Fail to create vector.\n", stderr);
+            return fdsa_failed;
+        }
+
+        for (j = 0; j < sizes[i]; ++j)
+        {
+            element[j] = (unsigned char)(j + 1);
+        }
+
+        if (vecApi->resize(vec, 1001, element) == fdsa_failed)
+        {
+            fputs("Fail to resize.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        element[0] = 0xff;
+        if (vecApi->fill(vec, 10, 7, element) == fdsa_failed)
+        {
+            fputs("Fail to fill.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        for (j = 0; j < 1001; ++j)
+        {
+            unsigned char expected = (j >= 10 && j < 17) ? 0xff : 1;
+            if (vecApi->at(vec, j, out) == fdsa_failed ||
+                out[0] != expected ||
+                out[sizes[i] - 1] != (sizes[i] == 1 ? expected :
+                                      (unsigned char)sizes[i]))
+            {
+                fputs("Data mismatch after fill.\n", stderr);
+                vecApi->destory(vec);
+                return fdsa_failed;
+            }
+        }
+
+        if (vecApi->destory(vec) == fdsa_failed)
+        {
+            fputs("Fail to destory vector.\n", stderr);
+            return fdsa_failed;
+        }
+    }
+
+    return fdsa_success;
+}
+
+fdsa_exitstate testAlignment(fdsa_vector_api *vecApi)
+{
+    const size_t alignments[] = {64, 4096};
+    size_t i;
+    for (i = 0; i < sizeof(alignments) / sizeof(alignments[0]); ++i)
+    {
+        fdsa_vector *vec = vecApi->createAligned(sizeof(double), 0,
+                                                 alignments[i]);
+        if (!vec)
+        {
+            fputs("Fail to create vector.\n", stderr);
+            return fdsa_failed;
+        }
+
+        // grow through small heap blocks up to a mapped buffer
+        double data = 1.0;
+        size_t j;
+        for (j = 0; j < (1 << 18); ++j)
+        {
+            if (vecApi->pushBack(vec, &data) == fdsa_failed)
+            {
+                fputs("Fail to pushback.\n", stderr);
+                vecApi->destory(vec);
+                return fdsa_failed;
+            }
+
+            if ((uintptr_t)vecApi->data(vec) % alignments[i])
+            {
+                fputs("Buffer is not aligned.\n", stderr);
+                vecApi->destory(vec);
+                return fdsa_failed;
+            }
+        }
+
+        void *taken = vecApi->takeData(vec);
+        if (!taken || (uintptr_t)taken % alignments[i])
+        {
+            fputs("Taken buffer is not aligned.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+#ifdef _WIN32
+        _aligned_free(taken);
+#else
+        free(taken);
+#endif
+        if (vecApi->destory(vec) == fdsa_failed)
+        {
+            fputs("Fail to destory vector.\n", stderr);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->createAligned(sizeof(double), 0, 48))
+    {
+        fputs("Invalid alignment is accepted.\n", stderr);
+        return fdsa_failed;
+    }
+
+    return fdsa_success;
+}
+
+fdsa_exitstate testInlineStorage(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->createEx(sizeof(int),
+                                        fdsa_vector_inlineStorage);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t capacity = 0;
+    if (vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 16)
+    {
+        fputs("Inline capacity mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // nothing to take from an empty inline buffer
+    if (vecApi->takeData(vec) ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 16)
+    {
+        fputs("Empty inline buffer is taken.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // the 17th element spills to the heap
+    int i;
+    for (i = 0; i < 17; ++i)
+    {
+        if (vecApi->pushBack(vec, &i) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    int *taken = vecApi->takeData(vec);
+    if (!taken)
+    {
+        fputs("Fail to take data.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < 17; ++i)
+    {
+        if (taken[i] != i)
+        {
+            fputs("Data mismatch after spill.\n", stderr);
+            free(taken);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    free(taken);
+
+    // back to the inline buffer after takeData
+    if (vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 16)
+    {
+        fputs("Inline capacity mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+int cmpInt(const void *lhs, const void *rhs)
+{
+    int a = *(const int *)lhs;
+    int b = *(const int *)rhs;
+    return (a > b) - (a < b);
+}
+
+typedef struct Record
+{
+    int unused;
+    long long key;
+} Record;
+
+fdsa_exitstate testSort(fdsa_vector_api *vecApi)
+{
+    // large enough to take the parallel path
+    const size_t count = 200003;
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    fdsa_vector *records = vecApi->create(sizeof(Record));
+    if (!vec || !records)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        if (vec) vecApi->destory(vec);
+        if (records) vecApi->destory(records);
+        return fdsa_failed;
+    }
+
+    unsigned seed = 12345;
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int data = (int)(seed >> 8) - (1 << 23);
+        Record record = {0, (long long)data * 1000};
+        if (vecApi->pushBack(vec, &data) == fdsa_failed ||
+            vecApi->pushBack(records, &record) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            vecApi->destory(records);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->sort(vec, cmpInt) == fdsa_failed ||
+        vecApi->radixSort(records, offsetof(Record, key), sizeof(long long),
+                          1) == fdsa_failed)
+    {
+        fputs("Fail to sort.\n", stderr);
+        vecApi->destory(vec);
+        vecApi->destory(records);
+        return fdsa_failed;
+    }
+
+    const int *data = vecApi->data(vec);
+    const Record *record = vecApi->data(records);
+    for (i = 1; i < count; ++i)
+    {
+        if (data[i - 1] > data[i] || record[i - 1].key > record[i].key ||
+            record[i].key != (long long)data[i] * 1000)
+        {
+            fputs("Vector is not sorted.\n", stderr);
+            vecApi->destory(vec);
+            vecApi->destory(records);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->radixSort(records, 12, 8, 0) != fdsa_failed)
+    {
+        fputs("Key out of element is accepted.\n", stderr);
+        vecApi->destory(vec);
+        vecApi->destory(records);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(records);
+    return vecApi->destory(vec);
+}
+
+// elements are i / 3, every value appears three times
+fdsa_exitstate testSearchSize(fdsa_vector_api *vecApi, size_t count)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        int data = (int)(i / 3);
+        if (vecApi->pushBack(vec, &data) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    fdsa_vectorIndex *index = vecApi->buildIndex(vec, cmpInt);
+    if (!index)
+    {
+        fputs("Fail to build index.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    int key;
+    for (key = -1; key <= (int)(count / 3) + 1; ++key)
+    {
+        size_t lower = key < 0 ? 0 : (size_t)key * 3;
+        size_t upper = key < 0 ? 0 : (size_t)(key + 1) * 3;
+        if (lower > count) lower = count;
+        if (upper > count) upper = count;
+
+        size_t res[6];
+        if (vecApi->lowerBound(vec, &key, cmpInt, &res[0]) == fdsa_failed ||
+            vecApi->upperBound(vec, &key, cmpInt, &res[1]) == fdsa_failed ||
+            vecApi->equalRange(vec, &key, cmpInt,
+                               &res[2], &res[3]) == fdsa_failed ||
+            vecApi->indexLowerBound(index, &key, &res[4]) == fdsa_failed ||
+            vecApi->indexUpperBound(index, &key, &res[5]) == fdsa_failed)
+        {
+            fputs("Fail to search.\n", stderr);
+            vecApi->destroyIndex(index);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+
+        if (res[0] != lower || res[1] != upper ||
+            res[2] != lower || res[3] != upper ||
+            res[4] != lower || res[5] != upper)
+        {
+            fprintf(stderr, "Search mismatch for key %d in %zu elements.\n",
+                    key, count);
+            vecApi->destroyIndex(index);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    vecApi->destroyIndex(index);
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testSearch(fdsa_vector_api *vecApi)
+{
+    const size_t counts[] = {0, 1, 2, 7, 64, 3001};
+    size_t i;
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+        if (testSearchSize(vecApi, counts[i]) == fdsa_failed)
+        {
+            return fdsa_failed;
+        }
+    }
+
+    return fdsa_success;
+}
+
+void markSeen(const void *element, void *ctx)
+{
+    ((char *)ctx)[*(const int *)element] = 1;
+}
+
+void doubleInt(void *element, void *ctx)
+{
+    (void)ctx;
+    *(int *)element *= 2;
+}
+
+void sumInt(void *acc, const void *rhs, void *ctx)
+{
+    (void)ctx;
+    *(long long *)acc += *(const int *)rhs;
+}
+
+void sumAcc(void *acc, const void *rhs, void *ctx)
+{
+    (void)ctx;
+    *(long long *)acc += *(const long long *)rhs;
+}
+
+fdsa_exitstate testForEach(fdsa_vector_api *vecApi)
+{
+    // several chunks for every worker
+    const int count = 100003;
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    char *seen = calloc(count, 1);
+    if (!vec || !seen)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        if (vec) vecApi->destory(vec);
+        free(seen);
+        return fdsa_failed;
+    }
+
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        if (vecApi->pushBack(vec, &i) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            free(seen);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->forEach(vec, markSeen, seen) == fdsa_failed)
+    {
+        fputs("Fail to run forEach.\n", stderr);
+        vecApi->destory(vec);
+        free(seen);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!seen[i])
+        {
+            fputs("Element is not visited.\n", stderr);
+            vecApi->destory(vec);
+            free(seen);
+            return fdsa_failed;
+        }
+    }
+
+    free(seen);
+    long long zero = 0;
+    long long sum = 0;
+    if (vecApi->transform(vec, doubleInt, NULL) == fdsa_failed ||
+        vecApi->reduce(vec, &zero, sizeof(long long),
+                       sumInt, sumAcc, NULL, &sum) == fdsa_failed)
+    {
+        fputs("Fail to transform or reduce.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    if (sum != (long long)count * (count - 1))
+    {
+        fputs("Reduce mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // the sequential path for a single chunk
+    if (vecApi->resize(vec, 3, &count) == fdsa_failed ||
+        vecApi->reduce(vec, &zero, sizeof(long long),
+                       sumInt, sumAcc, NULL, &sum) == fdsa_failed ||
+        sum != 6)
+    {
+        fputs("Small reduce mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+// counts its calls in ctx, if given
+int isOdd(const void *element, void *ctx)
+{
+    if (ctx) ++*(size_t *)ctx;
+    return ((const Record *)element)->key & 1;
+}
+
+fdsa_exitstate testInsertErase(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    // 0 1 2 3 4 5 6 7 built from the middle out
+    int head[] = {0, 1};
+    int middle[] = {3, 4, 6};
+    int data = 2;
+    if (vecApi->insertRange(vec, 0, middle, 3) == fdsa_failed ||
+        vecApi->insertRange(vec, 0, head, 2) == fdsa_failed ||
+        vecApi->insertAt(vec, 2, &data) == fdsa_failed ||
+        (data = 5, vecApi->insertAt(vec, 5, &data)) == fdsa_failed ||
+        (data = 7, vecApi->insertAt(vec, 7, &data)) == fdsa_failed ||
+        vecApi->insertAt(vec, 9, &data) != fdsa_failed)
+    {
+        fputs("Fail to insert.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    int expected[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    size_t size = 0;
+    vecApi->size(vec, &size);
+    if (size != 8 || memcmp(vecApi->data(vec), expected, sizeof(expected)))
+    {
+        fputs("Insert mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    int erased[] = {1, 4, 5, 6};
+    if (vecApi->eraseRange(vec, 2, 2) == fdsa_failed ||
+        vecApi->eraseAt(vec, 0) == fdsa_failed ||
+        vecApi->eraseAt(vec, 4) == fdsa_failed ||
+        vecApi->eraseRange(vec, 2, 3) != fdsa_failed)
+    {
+        fputs("Fail to erase.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->size(vec, &size);
+    if (size != 4 || memcmp(vecApi->data(vec), erased, sizeof(erased)))
+    {
+        fputs("Erase mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testRemoveIf(fdsa_vector_api *vecApi)
+{
+    const size_t count = 1000;
+    fdsa_vector *vec = vecApi->create(sizeof(Record));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        Record record = {(int)i, (long long)i - 500};
+        if (vecApi->pushBack(vec, &record) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    // drop the odd keys, then the keys below -100 and the keys above 300
+    size_t removed[3] = {0, 0, 0};
+    long long low = -100;
+    long long high = 300;
+    size_t calls = 0;
+    if (vecApi->removeIf(vec, isOdd, &calls, &removed[0]) == fdsa_failed ||
+        vecApi->removeIfKey(vec, offsetof(Record, key), sizeof(long long), 1,
+                            fdsa_vector_cmpLess, &low,
+                            &removed[1]) == fdsa_failed ||
+        vecApi->removeIfKey(vec, offsetof(Record, key), sizeof(long long), 1,
+                            fdsa_vector_cmpGreater, &high,
+                            &removed[2]) == fdsa_failed)
+    {
+        fputs("Fail to remove.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    size_t size = 0;
+    vecApi->size(vec, &size);
+    const Record *record = vecApi->data(vec);
+    if (calls != count || removed[0] != 500 || removed[1] != 200 ||
+        removed[2] != 99 || size != 201)
+    {
+        fputs("Remove count mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < size; ++i)
+    {
+        if (record[i].key != -100 + 2 * (long long)i ||
+            record[i].unused != (int)(record[i].key + 500))
+        {
+            fputs("Remove mismatch.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testMappedFile(fdsa_vector_api *vecApi)
+{
+    const char *path = "testVector.fdsa";
+    const size_t count = 1000;
+    fdsa_vector *vec = vecApi->createAligned(sizeof(Record),
+                                             fdsa_vector_lockMutex, 128);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        Record record = {(int)i, (long long)i * 3};
+        if (vecApi->pushBack(vec, &record) == fdsa_failed)
+        {
+            fputs("Fail to pushback.\n", stderr);
+            vecApi->destory(vec);
+            return fdsa_failed;
+        }
+    }
+
+    if (vecApi->save(vec, path) == fdsa_failed)
+    {
+        fputs("Fail to save vector.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    fdsa_vector *mapped = vecApi->openMapped(path,
+                                             fdsa_vector_verifyChecksum);
+    if (!mapped)
+    {
+        fputs("Fail to open mapped vector.\n", stderr);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
+
+    size_t size = 0;
+    Record record = {0, 0};
+    vecApi->size(mapped, &size);
+    const void *data = vecApi->data(mapped);
+    if (size != count || ((uintptr_t)data & 127) ||
+        memcmp(data, vecApi->data(vec), count * sizeof(Record)) ||
+        vecApi->at(mapped, 10, &record) == fdsa_failed || record.key != 30)
+    {
+        fputs("Mapped vector mismatch.\n", stderr);
+        vecApi->destory(mapped);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
+
+    if (vecApi->pushBack(mapped, &record) != fdsa_failed ||
+        vecApi->setValue(mapped, 0, &record) != fdsa_failed ||
+        vecApi->clear(mapped) != fdsa_failed ||
+        vecApi->eraseAt(mapped, 0) != fdsa_failed ||
+        vecApi->takeData(mapped))
+    {
+        fputs("Mapped vector is modified.\n", stderr);
+        vecApi->destory(mapped);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
+
+#ifndef _WIN32
+    // saving over the mapped file replaces it, the mapping stays intact
+    if (vecApi->save(mapped, path) == fdsa_failed ||
+        memcmp(vecApi->data(mapped), vecApi->data(vec),
+               count * sizeof(Record)))
+    {
+        fputs("Fail to save mapped vector to its own file.\n", stderr);
+        vecApi->destory(mapped);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
+#endif
+
+    vecApi->destory(mapped);
+    mapped = vecApi->openMapped(path, fdsa_vector_verifyChecksum);
+    if (!mapped)
+    {
+        fputs("Fail to reopen saved vector.\n", stderr);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
 
-#include "fdsa.h"
+    vecApi->destory(mapped);
 
-fdsa_exitstate dumpData(fdsa_vector_api *vecApi, fdsa_vector *vec)
+    // a corrupted element only fails the checksum
+    record.key = -1;
+    FILE *file = fopen(path, "r+b");
+    if (!file || fseek(file, 128, SEEK_SET) ||
+        fwrite(&record, sizeof(record), 1, file) != 1)
+    {
+        fputs("Fail to corrupt the file.\n", stderr);
+        if (file) fclose(file);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
+
+    fclose(file);
+    mapped = vecApi->openMapped(path, fdsa_vector_verifyChecksum);
+    if (mapped)
+    {
+        fputs("Checksum mismatch is not detected.\n", stderr);
+        vecApi->destory(mapped);
+        vecApi->destory(vec);
+        remove(path);
+        return fdsa_failed;
+    }
+
+    mapped = vecApi->openMapped(path, fdsa_vector_lockShared);
+    if (mapped) vecApi->destory(mapped);
+    remove(path);
+    if (!mapped)
+    {
+        fputs("Fail to open mapped vector.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    if (vecApi->openMapped(path, fdsa_vector_lockMutex))
+    {
+        fputs("Missing file is opened.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+typedef struct DeallocCount
+{
+    int calls;
+    size_t bytes;
+} DeallocCount;
+
+void countedFree(void *ptr, size_t bytes, void *ctx)
 {
+    DeallocCount *count = ctx;
+    ++count->calls;
+    count->bytes = bytes;
+    free(ptr);
+}
+
+fdsa_exitstate testAdopt(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    DeallocCount count = {0, 0};
+    int *buffer = malloc(8 * sizeof(int));
+    if (!buffer)
+    {
+        fputs("Fail to allocate memory.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    int i;
+    for (i = 0; i < 6; ++i)
+    {
+        buffer[i] = i;
+    }
+
     size_t size = 0;
-    if (vecApi->size(vec, &size) == fdsa_failed)
+    size_t capacity = 0;
+    if (vecApi->adopt(vec, buffer, 6, 8, countedFree, &count) == fdsa_failed ||
+        vecApi->data(vec) != buffer ||
+        vecApi->size(vec, &size) == fdsa_failed || size != 6 ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 8)
     {
-        fputs("Fail to get size.", stderr);
+        fputs("Fail to adopt.\n", stderr);
+        vecApi->destory(vec);
         return fdsa_failed;
     }
 
-    size_t i = 0;
-    int data = 0;
+    // growth moves the elements out and releases the adopted buffer
+    for (i = 6; i < 9; ++i)
+    {
+        vecApi->pushBack(vec, &i);
+    }
+
+    const int *data = vecApi->data(vec);
+    if (count.calls != 1 || count.bytes != 8 * sizeof(int) ||
+        data[0] != 0 || data[8] != 8)
+    {
+        fputs("Adopted buffer is not released on growth.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // hand the buffer over to a second vector without a copy
+    fdsa_vector_deallocFunc dealloc = NULL;
+    void *ctx = NULL;
+    void *taken = vecApi->takeBuffer(vec, &size, &capacity, &dealloc, &ctx);
+    fdsa_vector *other = vecApi->create(sizeof(int));
+    if (taken != data || size != 9 || capacity < 9 || !dealloc || !other ||
+        vecApi->adopt(other, taken, size, capacity, dealloc, ctx) ==
+        fdsa_failed || vecApi->data(other) != data)
+    {
+        fputs("Fail to hand over the buffer.\n", stderr);
+        if (other) vecApi->destory(other);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->size(vec, &size);
+    if (size || vecApi->data(vec))
+    {
+        fputs("Vector is not empty after takeBuffer.\n", stderr);
+        vecApi->destory(other);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // a mapped buffer, then reset releases the adopted one
+    int *large = malloc(1024 * sizeof(int));
+    if (!large || vecApi->resize(vec, 1 << 20, &count.calls) == fdsa_failed)
+    {
+        fputs("Fail to resize.\n", stderr);
+        free(large);
+        vecApi->destory(other);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    taken = vecApi->takeBuffer(vec, &size, &capacity, &dealloc, &ctx);
+    if (!taken || size != (1 << 20) || ((int *)taken)[size - 1] != 1)
+    {
+        fputs("Fail to take the buffer.\n", stderr);
+        free(large);
+        vecApi->destory(other);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    dealloc(taken, capacity * sizeof(int), ctx);
+    if (vecApi->adopt(vec, large, 0, 1024, countedFree, &count) ==
+        fdsa_failed || vecApi->reset(vec) == fdsa_failed || count.calls != 2)
+    {
+        fputs("Adopted buffer is not released on reset.\n", stderr);
+        vecApi->destory(other);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(other);
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testHugePages(fdsa_vector_api *vecApi)
+{
+    // no pool is reserved on most systems, MAP_HUGETLB falls back
+    fdsa_vector *vec = vecApi->createEx(sizeof(int), fdsa_vector_hugeTLB);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    const size_t hugePage = (size_t)2 << 20;
+    int data = 7;
+    size_t capacity = 0;
+    if (vecApi->resize(vec, 400000, &data) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed)
+    {
+        fputs("Fail to resize.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+#ifdef __linux__
+    if (((uintptr_t)vecApi->data(vec) & (hugePage - 1)) ||
+        capacity != hugePage / sizeof(int))
+    {
+        fputs("Buffer is not made of huge pages.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+#endif
+
+    // grow across several huge pages
+    data = 9;
+    if (vecApi->resize(vec, 3 * hugePage / sizeof(int), &data) == fdsa_failed ||
+        vecApi->at(vec, 399999, &data) == fdsa_failed || data != 7 ||
+        vecApi->at(vec, 400000, &data) == fdsa_failed || data != 9)
+    {
+        fputs("Huge page growth mismatch.\n", stderr);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    return vecApi->destory(vec);
+}
+
+fdsa_exitstate testShrink(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    fdsa_vector *small = vecApi->createEx(sizeof(int),
+                                          fdsa_vector_inlineStorage);
+    if (!vec || !small)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        if (vec) vecApi->destory(vec);
+        if (small) vecApi->destory(small);
+        return fdsa_failed;
+    }
+
+    int data = 3;
+    size_t capacity = 0;
+    if (vecApi->resize(vec, 10000, &data) == fdsa_failed ||
+        vecApi->clear(vec) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity < 10000 ||
+        vecApi->shrinkToFit(vec) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity ||
+        vecApi->data(vec))
+    {
+        fputs("Fail to shrink to fit.\n", stderr);
+        vecApi->destory(vec);
+        vecApi->destory(small);
+        return fdsa_failed;
+    }
+
+    // 100 elements of 10000 trims to 200, 60 of 200 stays
+    if (vecApi->setTrimPolicy(vec, 4.0, 16) == fdsa_failed ||
+        vecApi->resize(vec, 10000, &data) == fdsa_failed ||
+        vecApi->resize(vec, 100, &data) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 200 ||
+        vecApi->eraseRange(vec, 0, 40) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 200 ||
+        vecApi->at(vec, 59, &data) == fdsa_failed || data != 3 ||
+        vecApi->clear(vec) == fdsa_failed ||
+        vecApi->capacity(vec, &capacity) == fdsa_failed || capacity != 16)
+    {
+        fputs("Trim policy mismatch.\n", stderr);
+        vecApi->destory(vec);
+        vecApi->destory(small);
+        return fdsa_failed;
+    }
+
+    // the elements move back into the object
+    if (vecApi->resize(small, 100, &data) == fdsa_failed ||
+        vecApi->resize(small, 3, &data) == fdsa_failed ||
+        vecApi->shrinkToFit(small) == fdsa_failed ||
+        vecApi->capacity(small, &capacity) == fdsa_failed ||
+        capacity != 64 / sizeof(int) ||
+        vecApi->at(small, 2, &data) == fdsa_failed || data != 3)
+    {
+        fputs("Fail to shrink into inline storage.\n", stderr);
+        vecApi->destory(vec);
+        vecApi->destory(small);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(small);
+    return vecApi->destory(vec);
+}
+
+// every element of the snapshot is its index
+fdsa_exitstate checkSnapshot(fdsa_vector_api *vecApi,
+                             fdsa_vector *snap,
+                             size_t expected)
+{
+    size_t size = 0;
+    vecApi->size(snap, &size);
+    const int *data = vecApi->data(snap);
+    size_t i;
     for (i = 0; i < size; ++i)
     {
-        if (vecApi->at(vec, i, &data) == fdsa_failed)
-        {
-            fputs("Fail to get value.", stderr);
-            return fdsa_failed;
-        }
+        if (data[i] != (int)i) break;
+    }
 
-        printf("%d ", data);
+    if (size != expected || i != size)
+    {
+        fputs("Snapshot is modified.\n", stderr);
+        return fdsa_failed;
     }
 
-    printf("\n");
     return fdsa_success;
 }
 
+fdsa_exitstate testSnapshot(fdsa_vector_api *vecApi)
+{
+    fdsa_vector *vec = vecApi->create(sizeof(int));
+    if (!vec || vecApi->reserve(vec, 100) == fdsa_failed)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        if (vec) vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    int i;
+    for (i = 0; i < 10; ++i)
+    {
+        vecApi->pushBack(vec, &i);
+    }
+
+    // appends within the capacity share the buffer, a write copies it
+    const void *data = vecApi->data(vec);
+    fdsa_vector *snap = vecApi->snapshot(vec);
+    fdsa_vector *nested = snap ? vecApi->snapshot(snap) : NULL;
+    if (!snap || !nested || vecApi->data(snap) != data ||
+        vecApi->pushBack(vec, &i) == fdsa_failed || vecApi->data(vec) != data ||
+        vecApi->setValue(vec, 3, &i) == fdsa_failed ||
+        vecApi->data(vec) == data ||
+        vecApi->pushBack(snap, &i) != fdsa_failed ||
+        checkSnapshot(vecApi, snap, 10) == fdsa_failed)
+    {
+        fputs("Fail to share the buffer.\n", stderr);
+        if (nested) vecApi->destory(nested);
+        if (snap) vecApi->destory(snap);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // invalid arguments fail before the buffer is copied
+    fdsa_vector *shared = vecApi->snapshot(vec);
+    data = vecApi->data(vec);
+    if (!shared ||
+        vecApi->radixSort(vec, 2, sizeof(int), 0) != fdsa_failed ||
+        vecApi->removeIfKey(vec, 2, sizeof(int), 0, fdsa_vector_cmpLess, &i,
+                            NULL) != fdsa_failed ||
+        vecApi->removeIfKey(vec, 0, 3, 0, fdsa_vector_cmpLess, &i,
+                            NULL) != fdsa_failed ||
+        vecApi->data(vec) != data || vecApi->data(shared) != data)
+    {
+        fputs("Snapshot is detached by an invalid call.\n", stderr);
+        if (shared) vecApi->destory(shared);
+        vecApi->destory(nested);
+        vecApi->destory(snap);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(shared);
+
+    // the vector holds 0 1 2 10 4 ... 10 now,
+    // after clear pushBack writes over the snapshot
+    vecApi->destory(snap);
+    snap = vecApi->snapshot(vec);
+    vecApi->clear(vec);
+    i = -1;
+    int first = 0;
+    if (!snap || vecApi->pushBack(vec, &i) == fdsa_failed ||
+        vecApi->at(snap, 0, &first) == fdsa_failed || first != 0 ||
+        vecApi->at(snap, 3, &first) == fdsa_failed || first != 10)
+    {
+        fputs("Snapshot is modified by pushBack.\n", stderr);
+        if (snap) vecApi->destory(snap);
+        vecApi->destory(nested);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(snap);
+
+    // a write after every snapshot is gone takes the buffer back
+    snap = vecApi->snapshot(vec);
+    data = vecApi->data(vec);
+    if (snap) vecApi->destory(snap);
+    if (!snap || vecApi->setValue(vec, 0, &i) == fdsa_failed ||
+        vecApi->data(vec) != data)
+    {
+        fputs("Fail to take back a released buffer.\n", stderr);
+        vecApi->destory(nested);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    // growth into a mapping and takeBuffer leave the snapshot alone,
+    // and it outlives the vector
+    vecApi->clear(vec);
+    for (i = 0; i < 300000; ++i)
+    {
+        vecApi->pushBack(vec, &i);
+    }
+
+    snap = vecApi->snapshot(vec);
+    size_t size = 0;
+    size_t capacity = 0;
+    fdsa_vector_deallocFunc dealloc = NULL;
+    void *ctx = NULL;
+    void *taken = NULL;
+    if (snap && vecApi->resize(vec, 1000000, &i) != fdsa_failed)
+    {
+        taken = vecApi->takeBuffer(vec, &size, &capacity, &dealloc, &ctx);
+    }
+
+    if (!taken || vecApi->data(snap) == taken || size != 1000000)
+    {
+        fputs("Fail to grow or take a shared buffer.\n", stderr);
+        if (snap) vecApi->destory(snap);
+        vecApi->destory(nested);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    dealloc(taken, capacity * sizeof(int), ctx);
+    vecApi->destory(vec);
+    if (checkSnapshot(vecApi, snap, 300000) == fdsa_failed ||
+        checkSnapshot(vecApi, nested, 10) == fdsa_failed)
+    {
+        vecApi->destory(snap);
+        vecApi->destory(nested);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(snap);
+    vecApi->destory(nested);
+
+    // inline storage is copied into the snapshot
+    vec = vecApi->createEx(sizeof(int), fdsa_vector_inlineStorage);
+    if (!vec)
+    {
+        fputs("Fail to create vector.\n", stderr);
+        return fdsa_failed;
+    }
+
+    for (i = 0; i < 4; ++i)
+    {
+        vecApi->pushBack(vec, &i);
+    }
+
+    snap = vecApi->snapshot(vec);
+    if (!snap || vecApi->setValue(vec, 0, &i) == fdsa_failed ||
+        checkSnapshot(vecApi, snap, 4) == fdsa_failed)
+    {
+        fputs("Fail to snapshot inline storage.\n", stderr);
+        if (snap) vecApi->destory(snap);
+        vecApi->destory(vec);
+        return fdsa_failed;
+    }
+
+    vecApi->destory(snap);
+    return vecApi->destory(vec);
+}
+
 int main()
 {
     fDSA api;
@@ -245,5 +1583,85 @@ int main()
         return 1;
     }
 
+    if (testGrowth(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testLockPolicy(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testRange(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testFill(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testAlignment(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testInlineStorage(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testSort(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testSearch(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testForEach(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testInsertErase(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testRemoveIf(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testMappedFile(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testAdopt(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testHugePages(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testShrink(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
+    if (testSnapshot(vecApi) == fdsa_failed)
+    {
+        return 1;
+    }
+
     return 0;
 }
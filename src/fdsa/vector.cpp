@@ -23,26 +23,509 @@
 
 #include <mutex>
 #include <new>
+#include <shared_mutex>
 
 #include <cinttypes>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <cstdio>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "vector.h"
+#include "vectorimpl.h"
+#include "vectorkernel.h"
+
+// caller must hold vec->lock
+static size_t fdsa_vector_nextCapacity(fdsa_vector *vec, size_t required)
+{
+    size_t maxElements = SIZE_MAX / vec->sizeOfData;
+    if (required > maxElements)
+    {
+        return 0;
+    }
+
+    if (required <= vec->capacity)
+    {
+        return vec->capacity;
+    }
+
+    double grown = static_cast<double>(vec->capacity) * vec->growthFactor;
+    size_t step = maxElements - vec->capacity;
+    if (grown < static_cast<double>(maxElements))
+    {
+        step = static_cast<size_t>(grown) - vec->capacity;
+    }
+
+    if (step < vec->growthMinStep)
+    {
+        step = vec->growthMinStep;
+    }
+
+    if (vec->growthMaxStep && step > vec->growthMaxStep)
+    {
+        step = vec->growthMaxStep;
+    }
+
+    size_t ret = maxElements;
+    if (step < maxElements - vec->capacity)
+    {
+        ret = vec->capacity + step;
+    }
+
+    return (ret < required) ? required : ret;
+}
+
+#ifdef __linux__
+static size_t fdsa_vector_pageSize()
+{
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+#endif
+
+static uint8_t *fdsa_vector_allocHeap(size_t bytes, size_t alignment)
+{
+    if (alignment <= FDSA_VECTOR_HEAP_ALIGN)
+    {
+        return static_cast<uint8_t *>(malloc(bytes));
+    }
+
+#ifdef _WIN32
+    return static_cast<uint8_t *>(_aligned_malloc(bytes, alignment));
+#else
+    void *ret = NULL;
+    if (posix_memalign(&ret, alignment, bytes))
+    {
+        return NULL;
+    }
+
+    return static_cast<uint8_t *>(ret);
+#endif
+}
+
+// Point the vector at its empty buffer, which is the inline one
+// if inline storage is on. The old buffer is not released.
+// caller must hold vec->lock
+static void fdsa_vector_resetStorage(fdsa_vector *vec)
+{
+    if (vec->inlineCapacity)
+    {
+        vec->data = vec->inlineData;
+        vec->bytes = FDSA_VECTOR_INLINE_BYTES;
+        vec->capacity = vec->inlineCapacity;
+        vec->storage = fdsa_vector_storageInline;
+        vec->mappedTLB = false;
+        return;
+    }
+
+    vec->data = NULL;
+    vec->bytes = 0;
+    vec->capacity = 0;
+    vec->storage = fdsa_vector_storageHeap;
+    vec->mappedTLB = false;
+}
+
+static void fdsa_vector_releaseShared(fdsa_vectorShared *shared)
+{
+    if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        fdsa_vector_destroy(shared->owner);
+        delete shared;
+    }
+}
+
+// caller must hold vec->lock
+static void fdsa_vector_freeBuffer(fdsa_vector *vec)
+{
+    if (vec->shared)
+    {
+        // the last reference frees the buffer
+        fdsa_vector_releaseShared(vec->shared);
+        vec->shared = NULL;
+        vec->sharedSize = 0;
+        vec->file = NULL;
+        vec->fileBytes = 0;
+        vec->dealloc = NULL;
+        vec->deallocCtx = NULL;
+        fdsa_vector_resetStorage(vec);
+        return;
+    }
+
+    if (!vec->data) return;
+
+    switch (vec->storage)
+    {
+    case fdsa_vector_storageInline:
+        break;
+    case fdsa_vector_storageFile:
+        fdsa_vector_unmapFile(vec);
+        break;
+    case fdsa_vector_storageAdopted:
+        vec->dealloc(vec->data, vec->bytes, vec->deallocCtx);
+        vec->dealloc = NULL;
+        vec->deallocCtx = NULL;
+        break;
+#ifdef __linux__
+    case fdsa_vector_storageMapped:
+        munmap(vec->data, vec->bytes);
+        break;
+#endif
+#ifdef _WIN32
+    case fdsa_vector_storageAligned:
+        _aligned_free(vec->data);
+        break;
+#endif
+    default:
+        free(vec->data);
+        break;
+    }
+
+    fdsa_vector_resetStorage(vec);
+}
+
+#ifdef __linux__
+// Ask for transparent huge pages on the whole mapping.
+// caller must hold vec->lock
+static void fdsa_vector_adviseHuge(fdsa_vector *vec)
+{
+#ifdef MADV_HUGEPAGE
+    if (vec->hugePages && !vec->mappedTLB)
+    {
+        madvise(vec->data, vec->bytes, MADV_HUGEPAGE);
+    }
+#else
+    (void)vec;
+#endif
+}
+
+// Map bytes of anonymous memory, a multiple of the vector's mapping unit.
+// Without reserved huge pages MAP_HUGETLB fails and the mapping falls back
+// to transparent huge pages. Returns NULL on failure.
+// caller must hold vec->lock
+static uint8_t *fdsa_vector_mapPages(fdsa_vector *vec,
+                                     size_t bytes,
+                                     bool *mappedTLB)
+{
+    void *res = MAP_FAILED;
+    *mappedTLB = false;
+#ifdef MAP_HUGETLB
+    if (vec->hugeTLB)
+    {
+        res = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (res != MAP_FAILED)
+        {
+            *mappedTLB = true;
+            return static_cast<uint8_t *>(res);
+        }
+    }
+#endif
+
+    if (!vec->hugePages)
+    {
+        res = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (res == MAP_FAILED) ? NULL : static_cast<uint8_t *>(res);
+    }
+
+    // map one more huge page and trim both ends,
+    // so that the buffer starts on a huge page boundary
+    const size_t huge = FDSA_VECTOR_HUGE_PAGE;
+    if (bytes > SIZE_MAX - huge)
+    {
+        return NULL;
+    }
+
+    res = mmap(NULL, bytes + huge, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (res == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    uint8_t *base = static_cast<uint8_t *>(res);
+    size_t head = (huge - (reinterpret_cast<uintptr_t>(base) & (huge - 1))) &
+                  (huge - 1);
+    if (head)
+    {
+        munmap(base, head);
+    }
+
+    if (huge - head)
+    {
+        munmap(base + head + bytes, huge - head);
+    }
+
+#ifdef MADV_HUGEPAGE
+    madvise(base + head, bytes, MADV_HUGEPAGE);
+#endif
+    return base + head;
+}
+#endif
+
+// Deallocators handed out by fdsa_vector_takeBuffer.
+static void fdsa_vector_deallocHeap(void *ptr, size_t, void *)
+{
+    free(ptr);
+}
+
+#ifdef _WIN32
+static void fdsa_vector_deallocAligned(void *ptr, size_t, void *)
+{
+    _aligned_free(ptr);
+}
+#endif
+
+#ifdef __linux__
+static void fdsa_vector_deallocMapped(void *ptr, size_t bytes, void *)
+{
+    munmap(ptr, bytes);
+}
+#endif
+
+// Move the buffer to a block of newBytes bytes, keeping the first
+// vec->size elements. New bytes are left uninitialized.
+// caller must hold vec->lock
+static fdsa_exitstate fdsa_vector_reallocBuffer(fdsa_vector *vec,
+                                                size_t newBytes)
+{
+    size_t used = vec->size * vec->sizeOfData;
+    if (used > newBytes)
+    {
+        used = newBytes;
+    }
+
+    uint8_t *newData = NULL;
+
+#ifdef __linux__
+    size_t pageSize = fdsa_vector_pageSize();
+    if (newBytes >= FDSA_VECTOR_MAP_THRESHOLD && vec->alignment <= pageSize)
+    {
+        // huge page vectors map whole huge pages
+        size_t unit = vec->hugePages ? FDSA_VECTOR_HUGE_PAGE : pageSize;
+        if (newBytes > SIZE_MAX - unit)
+        {
+            return fdsa_failed;
+        }
+
+        newBytes = (newBytes + unit - 1) & ~(unit - 1);
+        void *res = MAP_FAILED;
+        if (vec->data && vec->storage == fdsa_vector_storageMapped &&
+            !vec->shared)
+        {
+            res = mremap(vec->data, vec->bytes, newBytes, MREMAP_MAYMOVE);
+            if (res != MAP_FAILED)
+            {
+                vec->data = static_cast<uint8_t *>(res);
+                vec->bytes = newBytes;
+                vec->capacity = newBytes / vec->sizeOfData;
+                fdsa_vector_adviseHuge(vec);
+                return fdsa_success;
+            }
+
+            // older kernels cannot mremap MAP_HUGETLB, copy instead
+            if (!vec->mappedTLB)
+            {
+                return fdsa_failed;
+            }
+        }
+
+        bool mappedTLB = false;
+        newData = fdsa_vector_mapPages(vec, newBytes, &mappedTLB);
+        if (!newData)
+        {
+            return fdsa_failed;
+        }
+
+        if (vec->data)
+        {
+            memcpy(newData, vec->data, used);
+        }
+
+        fdsa_vector_freeBuffer(vec);
+        vec->data = newData;
+        vec->bytes = newBytes;
+        vec->capacity = newBytes / vec->sizeOfData;
+        vec->storage = fdsa_vector_storageMapped;
+        vec->mappedTLB = mappedTLB;
+        return fdsa_success;
+    }
+#endif
+
+    if (vec->storage == fdsa_vector_storageHeap &&
+        vec->alignment <= FDSA_VECTOR_HEAP_ALIGN && !vec->shared)
+    {
+        // realloc lets the allocator extend the block in place
+        newData = static_cast<uint8_t *>(realloc(vec->data, newBytes));
+        if (!newData)
+        {
+            return fdsa_failed;
+        }
+
+        vec->data = newData;
+        vec->bytes = newBytes;
+        vec->capacity = newBytes / vec->sizeOfData;
+        return fdsa_success;
+    }
+
+    // aligned blocks cannot be realloc'ed,
+    // or the buffer leaves the mapping or the inline storage
+    newData = fdsa_vector_allocHeap(newBytes, vec->alignment);
+    if (!newData)
+    {
+        return fdsa_failed;
+    }
+
+    if (vec->data)
+    {
+        memcpy(newData, vec->data, used);
+    }
+
+    fdsa_vector_freeBuffer(vec);
+    vec->data = newData;
+    vec->bytes = newBytes;
+    vec->capacity = newBytes / vec->sizeOfData;
+    vec->storage = (vec->alignment > FDSA_VECTOR_HEAP_ALIGN) ?
+                   fdsa_vector_storageAligned : fdsa_vector_storageHeap;
+    return fdsa_success;
+}
+
+// caller must hold vec->lock
+static fdsa_exitstate fdsa_vector_reserveInternal(fdsa_vector *vec,
+                                                  size_t newSize)
+{
+    if (newSize <= vec->capacity)
+    {
+        // do nothing
+        return fdsa_success;
+    }
 
-typedef struct fdsa_vector
+    if (newSize > SIZE_MAX / vec->sizeOfData)
+    {
+        return fdsa_failed;
+    }
+
+    return fdsa_vector_reallocBuffer(vec, newSize * vec->sizeOfData);
+}
+
+// Shrink the buffer to newCapacity elements, newCapacity >= vec->size.
+// A vector with inline storage moves back into it when the elements fit.
+// caller must hold vec->lock
+static fdsa_exitstate fdsa_vector_shrinkInternal(fdsa_vector *vec,
+                                                 size_t newCapacity)
 {
-    uint8_t *data = NULL;
+    if (newCapacity >= vec->capacity)
+    {
+        // do nothing
+        return fdsa_success;
+    }
 
-    size_t sizeOfData = 0;
+    if (newCapacity <= vec->inlineCapacity || !newCapacity)
+    {
+        if (vec->storage == fdsa_vector_storageInline)
+        {
+            return fdsa_success;
+        }
 
-    size_t size = 0;
+        if (vec->inlineCapacity)
+        {
+            memcpy(vec->inlineData, vec->data, vec->size * vec->sizeOfData);
+        }
 
-    size_t capacity = 0;
+        fdsa_vector_freeBuffer(vec);
+        return fdsa_success;
+    }
 
-    std::mutex mutex;
-} fdsa_vector;
+    return fdsa_vector_reallocBuffer(vec, newCapacity * vec->sizeOfData);
+}
+
+// Give the vector a private copy of a buffer it shares with snapshots.
+// If every snapshot is gone already, the buffer is taken back as is.
+// caller must hold vec->lock
+fdsa_exitstate fdsa_vector_detachInternal(fdsa_vector *vec)
+{
+    fdsa_vectorShared *shared = vec->shared;
+    if (!shared)
+    {
+        return fdsa_success;
+    }
+
+    // Only the vector holds a reference, and new snapshots need vec->lock
+    // or an existing snapshot. The owner only keeps data alive, the vector
+    // still describes the buffer, so it is enough to drop the owner.
+    if (shared->refs.load(std::memory_order_acquire) == 1)
+    {
+        shared->owner->data = NULL;
+        fdsa_vector_destroy(shared->owner);
+        delete shared;
+        vec->shared = NULL;
+        vec->sharedSize = 0;
+        return fdsa_success;
+    }
+
+    // never realloc or mremap a shared buffer, so this copies
+    return fdsa_vector_reallocBuffer(vec, vec->bytes);
+}
+
+// caller must hold vec->lock
+fdsa_exitstate fdsa_vector_unshareInternal(fdsa_vector *vec, size_t first)
+{
+    if (!vec->shared || first >= vec->sharedSize)
+    {
+        return fdsa_success;
+    }
+
+    return fdsa_vector_detachInternal(vec);
+}
+
+// caller must hold vec->lock
+void fdsa_vector_trimInternal(fdsa_vector *vec)
+{
+    if (!(vec->trimThreshold > 0.0) || vec->capacity <= vec->trimMinCapacity)
+    {
+        return;
+    }
+
+    if (static_cast<double>(vec->size) * vec->trimThreshold >=
+        static_cast<double>(vec->capacity))
+    {
+        return;
+    }
+
+    // keep room for twice the size, so that a little growth
+    // right after the trim does not reallocate again
+    size_t newCapacity = vec->size * 2;
+    if (newCapacity < vec->trimMinCapacity)
+    {
+        newCapacity = vec->trimMinCapacity;
+    }
+
+    // on failure the larger buffer is kept, which is still valid
+    fdsa_vector_shrinkInternal(vec, newCapacity);
+}
+
+// caller must hold vec->lock
+static fdsa_exitstate fdsa_vector_growInternal(fdsa_vector *vec,
+                                               size_t required)
+{
+    if (required <= vec->capacity)
+    {
+        return fdsa_success;
+    }
+
+    size_t newCapacity = fdsa_vector_nextCapacity(vec, required);
+    if (!newCapacity)
+    {
+        return fdsa_failed;
+    }
+
+    return fdsa_vector_reserveInternal(vec, newCapacity);
+}
 
 extern "C"
 {
@@ -52,9 +535,14 @@ fdsa_exitstate fdsa_vector_init(fdsa_vector_api *ret)
     if (!ret) return fdsa_failed;
 
     ret->create = fdsa_vector_create;
+    ret->createEx = fdsa_vector_createEx;
+    ret->createAligned = fdsa_vector_createAligned;
     ret->destory = fdsa_vector_destroy;
     ret->at = fdsa_vector_at;
     ret->setValue = fdsa_vector_setValue;
+    ret->atRange = fdsa_vector_atRange;
+    ret->setRange = fdsa_vector_setRange;
+    ret->fill = fdsa_vector_fill;
     ret->clear = fdsa_vector_clear;
     ret->size = fdsa_vector_size;
     ret->capacity = fdsa_vector_capacity;
@@ -64,13 +552,64 @@ fdsa_exitstate fdsa_vector_init(fdsa_vector_api *ret)
     ret->append = fdsa_vector_append;
     ret->data = fdsa_vector_data;
     ret->takeData = fdsa_vector_takeData;
+    ret->setGrowthPolicy = fdsa_vector_setGrowthPolicy;
+    ret->sort = fdsa_vector_sort;
+    ret->radixSort = fdsa_vector_radixSort;
+    ret->lowerBound = fdsa_vector_lowerBound;
+    ret->upperBound = fdsa_vector_upperBound;
+    ret->equalRange = fdsa_vector_equalRange;
+    ret->buildIndex = fdsa_vector_buildIndex;
+    ret->destroyIndex = fdsa_vector_destroyIndex;
+    ret->indexLowerBound = fdsa_vector_indexLowerBound;
+    ret->indexUpperBound = fdsa_vector_indexUpperBound;
+    ret->forEach = fdsa_vector_forEach;
+    ret->transform = fdsa_vector_transform;
+    ret->reduce = fdsa_vector_reduce;
+    ret->insertAt = fdsa_vector_insertAt;
+    ret->insertRange = fdsa_vector_insertRange;
+    ret->eraseAt = fdsa_vector_eraseAt;
+    ret->eraseRange = fdsa_vector_eraseRange;
+    ret->removeIf = fdsa_vector_removeIf;
+    ret->removeIfKey = fdsa_vector_removeIfKey;
+    ret->save = fdsa_vector_save;
+    ret->openMapped = fdsa_vector_openMapped;
+    ret->adopt = fdsa_vector_adopt;
+    ret->takeBuffer = fdsa_vector_takeBuffer;
+    ret->reset = fdsa_vector_reset;
+    ret->shrinkToFit = fdsa_vector_shrinkToFit;
+    ret->setTrimPolicy = fdsa_vector_setTrimPolicy;
+    ret->snapshot = fdsa_vector_snapshot;
 
     return fdsa_success;
 }
 
 FDSA_API fdsa_vector *fdsa_vector_create(size_t sizeOfData)
 {
-    if (!sizeOfData)
+    return fdsa_vector_createEx(sizeOfData, fdsa_vector_lockMutex);
+}
+
+FDSA_API fdsa_vector *fdsa_vector_createEx(size_t sizeOfData, unsigned flags)
+{
+    return fdsa_vector_createAligned(sizeOfData, flags, 0);
+}
+
+FDSA_API fdsa_vector *fdsa_vector_createAligned(size_t sizeOfData,
+                                                unsigned flags,
+                                                size_t alignment)
+{
+    if (!sizeOfData || (flags & ~FDSA_VECTOR_KNOWN_FLAGS))
+    {
+        return NULL;
+    }
+
+    if (alignment & (alignment - 1))
+    {
+        // not a power of two
+        return NULL;
+    }
+
+    fdsa_lockPolicy policy;
+    if (fdsa_lock_policyFromFlags(flags, &policy) == fdsa_failed)
     {
         return NULL;
     }
@@ -82,6 +621,22 @@ FDSA_API fdsa_vector *fdsa_vector_create(size_t sizeOfData)
     }
 
     vec->sizeOfData = sizeOfData;
+    vec->copyElement = fdsa_vector_selectCopy(sizeOfData);
+    if (alignment > vec->alignment)
+    {
+        vec->alignment = alignment;
+    }
+
+    if ((flags & fdsa_vector_inlineStorage) &&
+        vec->alignment <= FDSA_VECTOR_HEAP_ALIGN)
+    {
+        vec->inlineCapacity = FDSA_VECTOR_INLINE_BYTES / sizeOfData;
+        fdsa_vector_resetStorage(vec);
+    }
+
+    vec->hugePages = (flags & (fdsa_vector_hugePages | fdsa_vector_hugeTLB));
+    vec->hugeTLB = (flags & fdsa_vector_hugeTLB);
+    vec->lock.policy = policy;
 
     return vec;
 }
@@ -90,58 +645,152 @@ FDSA_API fdsa_exitstate fdsa_vector_destroy(fdsa_vector *vec)
 {
     if (!vec) return fdsa_failed;
 
-    vec->mutex.lock();
-    if (vec->data)
+    vec->lock.lock();
+    fdsa_vector_freeBuffer(vec);
+    vec->lock.unlock();
+    delete vec;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_at(fdsa_vector *vec, size_t index, void *dst)
+{
+
+    if (!vec || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    uint8_t *data = vec->data;
+    data += (index * vec->sizeOfData);
+    vec->copyElement(static_cast<uint8_t *>(dst), data, vec->sizeOfData);
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_setValue(fdsa_vector *vec,
+                                    size_t index,
+                                    const void *src)
+{
+    if (!vec || !src)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (index >= vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, index) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    uint8_t *data = vec->data;
+    data += (index * vec->sizeOfData);
+    vec->copyElement(data,
+                     static_cast<const uint8_t *>(src),
+                     vec->sizeOfData);
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_atRange(fdsa_vector *vec,
+                                            size_t first,
+                                            size_t count,
+                                            void *dst)
+{
+    if (!vec || !dst || !count)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (first >= vec->size || count > vec->size - first)
+    {
+        return fdsa_failed;
+    }
+
+    memcpy(dst,
+           vec->data + (first * vec->sizeOfData),
+           count * vec->sizeOfData);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_setRange(fdsa_vector *vec,
+                                             size_t first,
+                                             size_t count,
+                                             const void *src)
+{
+    if (!vec || !src || !count)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (first >= vec->size || count > vec->size - first)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, first) == fdsa_failed)
     {
-        delete[] vec->data;
-        vec->data = NULL;
+        return fdsa_failed;
     }
 
-    vec->mutex.unlock();
-    delete vec;
+    memcpy(vec->data + (first * vec->sizeOfData),
+           src,
+           count * vec->sizeOfData);
     return fdsa_success;
 }
 
-FDSA_API fdsa_exitstate fdsa_vector_at(fdsa_vector *vec, size_t index, void *dst)
+FDSA_API fdsa_exitstate fdsa_vector_fill(fdsa_vector *vec,
+                                         size_t first,
+                                         size_t count,
+                                         const void *src)
 {
-
-    if (!vec || !dst)
+    if (!vec || !src || !count)
     {
         return fdsa_failed;
     }
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
-    if (index >= vec->size)
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
     {
         return fdsa_failed;
     }
 
-    uint8_t *data = vec->data;
-    data += (index * vec->sizeOfData);
-    memcpy(dst, data, vec->sizeOfData);
-
-    return fdsa_success;
-}
-
-FDSA_API fdsa_exitstate fdsa_vector_setValue(fdsa_vector *vec,
-                                    size_t index,
-                                    const void *src)
-{
-    if (!vec || !src)
+    if (first >= vec->size || count > vec->size - first)
     {
         return fdsa_failed;
     }
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
-    if (index >= vec->size)
+    if (fdsa_vector_unshareInternal(vec, first) == fdsa_failed)
     {
         return fdsa_failed;
     }
 
-    uint8_t *data = vec->data;
-    data += (index * vec->sizeOfData);
-    memcpy(data, src, vec->sizeOfData);
-
+    fdsa_vector_patternFill(vec->data + (first * vec->sizeOfData),
+                            static_cast<const uint8_t *>(src),
+                            count,
+                            vec->sizeOfData);
     return fdsa_success;
 }
 
@@ -149,8 +798,14 @@ FDSA_API fdsa_exitstate fdsa_vector_clear(fdsa_vector *vec)
 {
     if (!vec) return fdsa_failed;
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
     vec->size = 0;
+    fdsa_vector_trimInternal(vec);
     return fdsa_success;
 }
 
@@ -161,7 +816,7 @@ FDSA_API fdsa_exitstate fdsa_vector_size(fdsa_vector *vec, size_t *dst)
         return fdsa_failed;
     }
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::shared_lock<fdsa_lock> lock(vec->lock);
     *dst = vec->size;
 
     return fdsa_success;
@@ -174,7 +829,7 @@ FDSA_API fdsa_exitstate fdsa_vector_capacity(fdsa_vector *vec, size_t *dst)
         return fdsa_failed;
     }
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::shared_lock<fdsa_lock> lock(vec->lock);
     *dst = vec->capacity;
 
     return fdsa_success;
@@ -184,29 +839,13 @@ FDSA_API fdsa_exitstate fdsa_vector_reserve(fdsa_vector *vec, size_t newSize)
 {
     if (!vec) return fdsa_failed;
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
-    if (newSize <= vec->capacity)
-    {
-        // do nothing
-        return fdsa_success;
-    }
-
-    uint8_t *newData = new (std::nothrow) uint8_t[newSize * vec->sizeOfData]();
-    if (!newData)
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
     {
         return fdsa_failed;
     }
 
-    if (vec->data)
-    {
-        memcpy(newData, vec->data, vec->sizeOfData * vec->size);
-        delete[] vec->data;
-    }
-
-    vec->data = newData;
-    vec->capacity = newSize;
-
-    return fdsa_success;
+    return fdsa_vector_reserveInternal(vec, newSize);
 }
 
 FDSA_API fdsa_exitstate fdsa_vector_pushBack(fdsa_vector *vec, const void *src)
@@ -216,18 +855,30 @@ FDSA_API fdsa_exitstate fdsa_vector_pushBack(fdsa_vector *vec, const void *src)
         return fdsa_failed;
     }
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
     if (vec->size == vec->capacity)
     {
-        if (fdsa_vector_reserve(vec, vec->capacity + 1) == fdsa_failed)
+        if (fdsa_vector_growInternal(vec, vec->size + 1) == fdsa_failed)
         {
             return fdsa_failed;
         }
     }
 
+    if (fdsa_vector_unshareInternal(vec, vec->size) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
     uint8_t *data = vec->data;
     data += (vec->size * vec->sizeOfData);
-    memcpy(data, src, vec->sizeOfData);
+    vec->copyElement(data,
+                     static_cast<const uint8_t *>(src),
+                     vec->sizeOfData);
     ++vec->size;
 
     return fdsa_success;
@@ -242,32 +893,36 @@ FDSA_API fdsa_exitstate fdsa_vector_resize(fdsa_vector *vec,
         return fdsa_failed;
     }
 
-    if (vec->capacity < amount)
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
     {
-        if (fdsa_vector_reserve(vec, amount) == fdsa_failed)
-        {
-            return fdsa_failed;
-        }
+        return fdsa_failed;
     }
 
-    if (vec->size > amount)
+    if (fdsa_vector_growInternal(vec, amount) == fdsa_failed)
     {
-        std::lock_guard<std::mutex> lock(vec->mutex);
-        vec->size = amount;
+        return fdsa_failed;
     }
-    else if (vec->size < amount)
+
+    if (fdsa_vector_unshareInternal(vec, vec->size) == fdsa_failed)
     {
-        // vec->capacity >= amount
-        size_t i;
-        for (i = vec->size; i < amount; ++i)
-        {
-            if (fdsa_vector_pushBack(vec, src) == fdsa_failed)
-            {
-                fputs("fdsa_vector_resize: You should never see this line.",
-                      stderr);
-                return fdsa_failed;
-            }
-        }
+        return fdsa_failed;
+    }
+
+    // vec->capacity >= amount
+    if (amount > vec->size)
+    {
+        fdsa_vector_patternFill(vec->data + (vec->size * vec->sizeOfData),
+                                static_cast<const uint8_t *>(src),
+                                amount - vec->size,
+                                vec->sizeOfData);
+    }
+
+    bool shrunk = (amount < vec->size);
+    vec->size = amount;
+    if (shrunk)
+    {
+        fdsa_vector_trimInternal(vec);
     }
 
     return fdsa_success;
@@ -279,8 +934,23 @@ FDSA_API fdsa_exitstate fdsa_vector_append(fdsa_vector *vec,
 {
     if (!vec || !in || !inLen) return fdsa_failed;
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
-    if (fdsa_vector_reserve(vec, vec->capacity + inLen) == fdsa_failed)
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (inLen > SIZE_MAX - vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_growInternal(vec, vec->size + inLen) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, vec->size) == fdsa_failed)
     {
         return fdsa_failed;
     }
@@ -293,11 +963,93 @@ FDSA_API fdsa_exitstate fdsa_vector_append(fdsa_vector *vec,
     return fdsa_success;
 }
 
+FDSA_API fdsa_exitstate fdsa_vector_insertAt(fdsa_vector *vec,
+                                             size_t index,
+                                             const void *src)
+{
+    return fdsa_vector_insertRange(vec, index, src, 1);
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_insertRange(fdsa_vector *vec,
+                                                size_t index,
+                                                const void *src,
+                                                size_t count)
+{
+    if (!vec || !src || !count) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (index > vec->size || count > SIZE_MAX - vec->size)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_growInternal(vec, vec->size + count) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, index) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    size_t sizeOfData = vec->sizeOfData;
+    uint8_t *data = vec->data + (index * sizeOfData);
+    memmove(data + (count * sizeOfData),
+            data,
+            (vec->size - index) * sizeOfData);
+    memcpy(data, src, count * sizeOfData);
+    vec->size += count;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_eraseAt(fdsa_vector *vec, size_t index)
+{
+    return fdsa_vector_eraseRange(vec, index, 1);
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_eraseRange(fdsa_vector *vec,
+                                               size_t first,
+                                               size_t count)
+{
+    if (!vec || !count) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (first >= vec->size || count > vec->size - first)
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, first) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    size_t sizeOfData = vec->sizeOfData;
+    uint8_t *data = vec->data + (first * sizeOfData);
+    memmove(data,
+            data + (count * sizeOfData),
+            (vec->size - first - count) * sizeOfData);
+    vec->size -= count;
+    fdsa_vector_trimInternal(vec);
+    return fdsa_success;
+}
+
 FDSA_API const void *fdsa_vector_data(fdsa_vector *vec)
 {
     if (!vec) return NULL;
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::shared_lock<fdsa_lock> lock(vec->lock);
     return vec->data;
 }
 
@@ -305,13 +1057,318 @@ FDSA_API void *fdsa_vector_takeData(fdsa_vector *vec)
 {
     if (!vec) return NULL;
 
-    std::lock_guard<std::mutex> lock(vec->mutex);
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return NULL;
+    }
+
+    uint8_t *ret = vec->data;
+    if (ret && (vec->storage == fdsa_vector_storageMapped ||
+                vec->storage == fdsa_vector_storageInline ||
+                vec->storage == fdsa_vector_storageAdopted || vec->shared))
+    {
+        // caller releases the buffer with free(),
+        // an empty vector hands out nothing
+        size_t bytes = vec->size * vec->sizeOfData;
+        ret = NULL;
+        if (bytes)
+        {
+            ret = fdsa_vector_allocHeap(bytes, vec->alignment);
+            if (!ret)
+            {
+                return NULL;
+            }
+
+            memcpy(ret, vec->data, bytes);
+        }
+
+        fdsa_vector_freeBuffer(vec);
+    }
+    else
+    {
+        fdsa_vector_resetStorage(vec);
+    }
+
+    vec->size = 0;
+    return ret;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_shrinkToFit(fdsa_vector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    return fdsa_vector_shrinkInternal(vec, vec->size);
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_setTrimPolicy(fdsa_vector *vec,
+                                                  double threshold,
+                                                  size_t minCapacity)
+{
+    if (!vec || (threshold != 0.0 && !(threshold > 2.0)))
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    vec->trimThreshold = threshold;
+    vec->trimMinCapacity = minCapacity;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_vector *fdsa_vector_snapshot(fdsa_vector *vec)
+{
+    if (!vec) return NULL;
+
+    // snapshots are immutable and need no locking
+    fdsa_vector *ret = fdsa_vector_createAligned(vec->sizeOfData,
+                                                 fdsa_vector_lockNone, 0);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    ret->alignment = vec->alignment;
+    ret->storage = fdsa_vector_storageShared;
+    if (!vec->data)
+    {
+        return ret;
+    }
+
+    // the inline buffer lives in the vector object,
+    // so the snapshot owns a copy of it instead
+    bool copied = (vec->storage == fdsa_vector_storageInline);
+    fdsa_vectorShared *shared = vec->shared;
+    if (!shared)
+    {
+        shared = new (std::nothrow) fdsa_vectorShared;
+        fdsa_vector *owner = fdsa_vector_createAligned(vec->sizeOfData,
+                                                       fdsa_vector_lockNone,
+                                                       0);
+        if (!shared || !owner)
+        {
+            delete shared;
+            fdsa_vector_destroy(owner);
+            fdsa_vector_destroy(ret);
+            return NULL;
+        }
+
+        owner->alignment = vec->alignment;
+        if (copied)
+        {
+            owner->data = fdsa_vector_allocHeap(FDSA_VECTOR_INLINE_BYTES,
+                                                vec->alignment);
+            if (!owner->data)
+            {
+                delete shared;
+                fdsa_vector_destroy(owner);
+                fdsa_vector_destroy(ret);
+                return NULL;
+            }
+
+            memcpy(owner->data, vec->data, vec->size * vec->sizeOfData);
+            owner->bytes = FDSA_VECTOR_INLINE_BYTES;
+        }
+        else
+        {
+            // the owner takes over releasing the buffer
+            owner->data = vec->data;
+            owner->bytes = vec->bytes;
+            owner->storage = vec->storage;
+            owner->file = vec->file;
+            owner->fileBytes = vec->fileBytes;
+            owner->dealloc = vec->dealloc;
+            owner->deallocCtx = vec->deallocCtx;
+            owner->mappedTLB = vec->mappedTLB;
+        }
+
+        shared->owner = owner;
+        shared->refs.store(copied ? 0 : 1, std::memory_order_relaxed);
+        if (!copied)
+        {
+            vec->shared = shared;
+        }
+    }
+
+    shared->refs.fetch_add(1, std::memory_order_relaxed);
+    if (!copied && vec->size > vec->sharedSize)
+    {
+        vec->sharedSize = vec->size;
+    }
+
+    ret->shared = shared;
+    ret->data = shared->owner->data;
+    ret->size = vec->size;
+    ret->capacity = vec->size;
+    ret->bytes = vec->size * vec->sizeOfData;
+    return ret;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_adopt(fdsa_vector *vec,
+                                          void *ptr,
+                                          size_t size,
+                                          size_t capacity,
+                                          fdsa_vector_deallocFunc dealloc,
+                                          void *ctx)
+{
+    if (!vec || !ptr || !capacity || size > capacity || !dealloc)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (capacity > SIZE_MAX / vec->sizeOfData ||
+        (reinterpret_cast<uintptr_t>(ptr) & (vec->alignment - 1)))
+    {
+        return fdsa_failed;
+    }
+
+    fdsa_vector_freeBuffer(vec);
+    vec->data = static_cast<uint8_t *>(ptr);
+    vec->bytes = capacity * vec->sizeOfData;
+    vec->capacity = capacity;
+    vec->size = size;
+    vec->storage = fdsa_vector_storageAdopted;
+    vec->dealloc = dealloc;
+    vec->deallocCtx = ctx;
+    return fdsa_success;
+}
+
+FDSA_API void *fdsa_vector_takeBuffer(fdsa_vector *vec,
+                                      size_t *size,
+                                      size_t *capacity,
+                                      fdsa_vector_deallocFunc *dealloc,
+                                      void **ctx)
+{
+    if (!vec || !size || !capacity || !dealloc || !ctx) return NULL;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return NULL;
+    }
+
+    // a snapshot still holds the buffer
+    if (fdsa_vector_detachInternal(vec) == fdsa_failed)
+    {
+        return NULL;
+    }
+
     uint8_t *ret = vec->data;
+    fdsa_vector_deallocFunc retDealloc = fdsa_vector_deallocHeap;
+    void *retCtx = NULL;
+    switch (vec->storage)
+    {
+    case fdsa_vector_storageInline:
+        // the only storage that has to be copied out
+        if (!vec->size) return NULL;
 
-    vec->capacity = 0;
+        ret = fdsa_vector_allocHeap(vec->size * vec->sizeOfData,
+                                    vec->alignment);
+        if (!ret)
+        {
+            return NULL;
+        }
+
+        memcpy(ret, vec->data, vec->size * vec->sizeOfData);
+        *capacity = vec->size;
+        break;
+    case fdsa_vector_storageAdopted:
+        retDealloc = vec->dealloc;
+        retCtx = vec->deallocCtx;
+        *capacity = vec->capacity;
+        break;
+#ifdef __linux__
+    case fdsa_vector_storageMapped:
+    {
+        // dealloc only learns capacity * sizeOfData,
+        // unmap the pages past it now
+        size_t unit = vec->mappedTLB ? FDSA_VECTOR_HUGE_PAGE :
+                      fdsa_vector_pageSize();
+        size_t used = (vec->capacity * vec->sizeOfData + unit - 1) &
+                      ~(unit - 1);
+        if (used < vec->bytes)
+        {
+            munmap(vec->data + used, vec->bytes - used);
+        }
+
+        retDealloc = fdsa_vector_deallocMapped;
+        *capacity = vec->capacity;
+        break;
+    }
+#endif
+#ifdef _WIN32
+    case fdsa_vector_storageAligned:
+        retDealloc = fdsa_vector_deallocAligned;
+        *capacity = vec->capacity;
+        break;
+#endif
+    default:
+        if (!ret) return NULL;
+
+        *capacity = vec->capacity;
+        break;
+    }
+
+    *size = vec->size;
+    *dealloc = retDealloc;
+    *ctx = retCtx;
+
+    // the buffer now belongs to the caller
+    vec->dealloc = NULL;
+    vec->deallocCtx = NULL;
+    fdsa_vector_resetStorage(vec);
     vec->size = 0;
-    vec->data = NULL;
     return ret;
 }
 
+FDSA_API fdsa_exitstate fdsa_vector_reset(fdsa_vector *vec)
+{
+    if (!vec) return fdsa_failed;
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    fdsa_vector_freeBuffer(vec);
+    vec->size = 0;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_setGrowthPolicy(fdsa_vector *vec,
+                                                    double factor,
+                                                    size_t minStep,
+                                                    size_t maxStep)
+{
+    if (!vec || !(factor >= 1.0) || !minStep)
+    {
+        return fdsa_failed;
+    }
+
+    if (maxStep && maxStep < minStep)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    vec->growthFactor = factor;
+    vec->growthMinStep = minStep;
+    vec->growthMaxStep = maxStep;
+    return fdsa_success;
+}
+
 } // end extern "C"
@@ -0,0 +1,844 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "parallel.h"
+#include "prefetch.h"
+#include "vector.h"
+#include "vectorimpl.h"
+#include "vectorkernel.h"
+
+// vectors shorter than this are sorted with a single qsort
+#define FDSA_VECTOR_PARALLEL_SORT_MIN (static_cast<size_t>(1) << 16)
+
+// forEach, transform and reduce hand out chunks of about this many bytes
+#define FDSA_VECTOR_CHUNK_BYTES (static_cast<size_t>(1) << 14)
+
+typedef struct fdsa_vectorIndex
+{
+    uint8_t *data = NULL; // elements in Eytzinger order, 1-based
+
+    size_t *rank = NULL; // rank[k] is the index in the vector of data[k]
+
+    size_t size = 0;
+
+    size_t sizeOfData = 0;
+
+    fdsa_cmpFunc cmp = NULL;
+} fdsa_vectorIndex;
+
+// Elements per chunk, a whole number of cache lines so neighbouring chunks
+// of a line-aligned buffer never share one. It only depends on the element
+// size, which keeps the reduce combine order independent of the workers.
+static size_t fdsa_vector_chunkLength(size_t sizeOfData)
+{
+    size_t a = FDSA_CACHE_LINE;
+    size_t b = sizeOfData;
+    while (b)
+    {
+        size_t tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+
+    size_t lineElements = FDSA_CACHE_LINE / a;
+    size_t ret = FDSA_VECTOR_CHUNK_BYTES / (lineElements * sizeOfData);
+    return ret ? ret * lineElements : lineElements;
+}
+
+// Stream compaction for fdsa_vector_removeIfKey. op has one bit for each
+// of less, equal and greater, so the predicate is a shift and every
+// survivor is stored unconditionally: the write index only advances when
+// the element is kept. width is the element size, or 0 if it is not one
+// of the fixed copy widths. Returns the number of elements kept.
+template<typename Key, size_t width>
+static size_t fdsa_vector_compactKey(uint8_t *data,
+                                     size_t size,
+                                     size_t sizeOfData,
+                                     size_t keyOffset,
+                                     Key value,
+                                     unsigned op)
+{
+    if (width) sizeOfData = width;
+
+    Key key;
+    size_t i = 0;
+    for (; i < size; ++i)
+    {
+        // nothing moves before the first removed element
+        memcpy(&key, data + (i * sizeOfData) + keyOffset, sizeof(Key));
+        if ((op >> ((key > value) * 2 + (key == value))) & 1) break;
+    }
+
+    // element i is removed, so the copies below never overlap
+    size_t out = i;
+    for (++i; i < size; ++i)
+    {
+        const uint8_t *src = data + (i * sizeOfData);
+        memcpy(&key, src + keyOffset, sizeof(Key));
+        memcpy(data + (out * sizeOfData), src, sizeOfData);
+        out += !((op >> ((key > value) * 2 + (key == value))) & 1);
+    }
+
+    return out;
+}
+
+template<typename Key>
+static size_t fdsa_vector_compactKeyOf(fdsa_vector *vec,
+                                       size_t keyOffset,
+                                       const void *value,
+                                       unsigned op)
+{
+    Key key;
+    memcpy(&key, value, sizeof(Key));
+    uint8_t *data = vec->data;
+    size_t size = vec->size;
+    size_t sizeOfData = vec->sizeOfData;
+    switch (sizeOfData)
+    {
+    case 1:
+        return fdsa_vector_compactKey<Key, 1>(data, size, sizeOfData,
+                                              keyOffset, key, op);
+    case 2:
+        return fdsa_vector_compactKey<Key, 2>(data, size, sizeOfData,
+                                              keyOffset, key, op);
+    case 4:
+        return fdsa_vector_compactKey<Key, 4>(data, size, sizeOfData,
+                                              keyOffset, key, op);
+    case 8:
+        return fdsa_vector_compactKey<Key, 8>(data, size, sizeOfData,
+                                              keyOffset, key, op);
+    case 16:
+        return fdsa_vector_compactKey<Key, 16>(data, size, sizeOfData,
+                                               keyOffset, key, op);
+    case 32:
+        return fdsa_vector_compactKey<Key, 32>(data, size, sizeOfData,
+                                               keyOffset, key, op);
+    default:
+        return fdsa_vector_compactKey<Key, 0>(data, size, sizeOfData,
+                                              keyOffset, key, op);
+    }
+}
+
+// Number of leading elements of the sorted run [data, data + size)
+// that compare less than key (or not greater, if inclusive is set).
+// The loop has no data-dependent branch: both possible next probes are
+// prefetched and the compare result only selects the next base.
+static size_t fdsa_vector_search(const uint8_t *data,
+                                 size_t size,
+                                 size_t sizeOfData,
+                                 const void *key,
+                                 fdsa_cmpFunc cmp,
+                                 bool inclusive)
+{
+    if (!size) return 0;
+
+    const int limit = inclusive ? 1 : 0;
+    const uint8_t *base = data;
+    while (size > 1)
+    {
+        size_t half = size / 2;
+        FDSA_PREFETCH(base + ((half / 2) * sizeOfData));
+        FDSA_PREFETCH(base + ((half + half / 2) * sizeOfData));
+        base = (cmp(base + (half * sizeOfData), key) < limit) ?
+               base + (half * sizeOfData) : base;
+        size -= half;
+    }
+
+    return static_cast<size_t>(base - data) / sizeOfData +
+           (cmp(base, key) < limit);
+}
+
+static inline unsigned fdsa_vectorIndex_trailingOnes(size_t in)
+{
+    unsigned ret = 0;
+    while (in & 1)
+    {
+        in >>= 1;
+        ++ret;
+    }
+
+    return ret;
+}
+
+// Fill the Eytzinger layout in order, node k has children 2k and 2k + 1.
+static size_t fdsa_vectorIndex_build(fdsa_vectorIndex *index,
+                                     const uint8_t *sorted,
+                                     size_t next,
+                                     size_t k)
+{
+    if (k > index->size) return next;
+
+    next = fdsa_vectorIndex_build(index, sorted, next, k * 2);
+    memcpy(index->data + (k * index->sizeOfData),
+           sorted + (next * index->sizeOfData),
+           index->sizeOfData);
+    index->rank[k] = next;
+    return fdsa_vectorIndex_build(index, sorted, next + 1, k * 2 + 1);
+}
+
+static size_t fdsa_vectorIndex_search(fdsa_vectorIndex *index,
+                                      const void *key,
+                                      bool inclusive)
+{
+    const int limit = inclusive ? 1 : 0;
+    size_t sizeOfData = index->sizeOfData;
+    size_t k = 1;
+    while (k <= index->size)
+    {
+        // the 16 descendants four levels down are contiguous
+        FDSA_PREFETCH(index->data + ((k * 16) * sizeOfData));
+        k = k * 2 + (index->cmp(index->data + (k * sizeOfData), key) < limit);
+    }
+
+    // drop the trailing right turns and the last left turn
+    k >>= fdsa_vectorIndex_trailingOnes(k) + 1;
+    return k ? index->rank[k] : index->size;
+}
+
+// Merge the sorted runs [a, aEnd) and [b, bEnd) into out.
+// Equal elements keep their order.
+static void fdsa_vector_merge(fdsa_vector *vec,
+                              fdsa_cmpFunc cmp,
+                              const uint8_t *a, const uint8_t *aEnd,
+                              const uint8_t *b, const uint8_t *bEnd,
+                              uint8_t *out)
+{
+    size_t sizeOfData = vec->sizeOfData;
+    while (a < aEnd && b < bEnd)
+    {
+        if (cmp(b, a) < 0)
+        {
+            vec->copyElement(out, b, sizeOfData);
+            b += sizeOfData;
+        }
+        else
+        {
+            vec->copyElement(out, a, sizeOfData);
+            a += sizeOfData;
+        }
+
+        out += sizeOfData;
+    }
+
+    memcpy(out, a, static_cast<size_t>(aEnd - a));
+    out += aEnd - a;
+    memcpy(out, b, static_cast<size_t>(bEnd - b));
+}
+
+extern "C"
+{
+
+FDSA_API fdsa_exitstate fdsa_vector_sort(fdsa_vector *vec, fdsa_cmpFunc cmp)
+{
+    if (!vec || !cmp)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, 0) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    size_t size = vec->size;
+    size_t sizeOfData = vec->sizeOfData;
+    size_t runs = fdsa_parallel_workers();
+    if (size < 2)
+    {
+        return fdsa_success;
+    }
+
+    uint8_t *tmp = NULL;
+    if (size >= FDSA_VECTOR_PARALLEL_SORT_MIN && runs > 1)
+    {
+        tmp = static_cast<uint8_t *>(malloc(size * sizeOfData));
+    }
+
+    if (!tmp)
+    {
+        qsort(vec->data, size, sizeOfData, cmp);
+        return fdsa_success;
+    }
+
+    // sort one run per worker, then merge pairs of runs until one is left
+    std::vector<size_t> bounds(runs + 1);
+    size_t i;
+    for (i = 0; i <= runs; ++i)
+    {
+        bounds[i] = size / runs * i + (size % runs) * i / runs;
+    }
+
+    uint8_t *src = vec->data;
+    uint8_t *dst = tmp;
+    fdsa_parallel_run(runs, [&](size_t run)
+    {
+        qsort(src + (bounds[run] * sizeOfData),
+              bounds[run + 1] - bounds[run],
+              sizeOfData,
+              cmp);
+    });
+
+    while (runs > 1)
+    {
+        size_t merged = (runs + 1) / 2;
+        fdsa_parallel_run(merged, [&](size_t pair)
+        {
+            size_t left = pair * 2;
+            uint8_t *a = src + (bounds[left] * sizeOfData);
+            uint8_t *aEnd = src + (bounds[left + 1] * sizeOfData);
+            uint8_t *out = dst + (bounds[left] * sizeOfData);
+            if (left + 1 == runs)
+            {
+                // odd run out
+                memcpy(out, a, static_cast<size_t>(aEnd - a));
+                return;
+            }
+
+            uint8_t *bEnd = src + (bounds[left + 2] * sizeOfData);
+            fdsa_vector_merge(vec, cmp, a, aEnd, aEnd, bEnd, out);
+        });
+
+        for (i = 0; i < merged; ++i)
+        {
+            size_t right = (i * 2 + 2 < runs) ? (i * 2 + 2) : runs;
+            bounds[i + 1] = bounds[right];
+        }
+
+        runs = merged;
+        uint8_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != vec->data)
+    {
+        memcpy(vec->data, src, size * sizeOfData);
+    }
+
+    free(tmp);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_radixSort(fdsa_vector *vec,
+                                              size_t keyOffset,
+                                              size_t keySize,
+                                              int isSigned)
+{
+    if (!vec)
+    {
+        return fdsa_failed;
+    }
+
+    if (keySize != 1 && keySize != 2 && keySize != 4 && keySize != 8)
+    {
+        return fdsa_failed;
+    }
+
+    // the element size never changes, no need to hold the lock
+    size_t sizeOfData = vec->sizeOfData;
+    if (keyOffset > sizeOfData || keySize > sizeOfData - keyOffset)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, 0) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    size_t size = vec->size;
+
+    if (size < 2)
+    {
+        return fdsa_success;
+    }
+
+    uint8_t *tmp = static_cast<uint8_t *>(malloc(size * sizeOfData));
+    if (!tmp)
+    {
+        return fdsa_failed;
+    }
+
+    // digit d is the d-th least significant byte of the key
+    const uint16_t endianTest = 1;
+    const bool littleEndian =
+        *reinterpret_cast<const uint8_t *>(&endianTest) == 1;
+    size_t digitOffset[8];
+    size_t digit;
+    for (digit = 0; digit < keySize; ++digit)
+    {
+        digitOffset[digit] = keyOffset +
+                             (littleEndian ? digit : keySize - 1 - digit);
+    }
+
+    // flip the sign bit so that negative keys sort first
+    const uint8_t signFlip = isSigned ? 0x80 : 0;
+
+    // one pass builds the histograms of every digit
+    size_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    const uint8_t *element = vec->data;
+    size_t i;
+    for (i = 0; i < size; ++i, element += sizeOfData)
+    {
+        for (digit = 0; digit + 1 < keySize; ++digit)
+        {
+            ++counts[digit][element[digitOffset[digit]]];
+        }
+
+        ++counts[keySize - 1][element[digitOffset[keySize - 1]] ^ signFlip];
+    }
+
+    uint8_t *src = vec->data;
+    uint8_t *dst = tmp;
+    for (digit = 0; digit < keySize; ++digit)
+    {
+        size_t *count = counts[digit];
+        uint8_t flip = (digit + 1 == keySize) ? signFlip : 0;
+        size_t offset = digitOffset[digit];
+
+        // every key has the same digit, nothing to do in this pass
+        if (count[src[offset] ^ flip] == size)
+        {
+            continue;
+        }
+
+        size_t sum = 0;
+        for (i = 0; i < 256; ++i)
+        {
+            size_t tmpCount = count[i];
+            count[i] = sum;
+            sum += tmpCount;
+        }
+
+        element = src;
+        for (i = 0; i < size; ++i, element += sizeOfData)
+        {
+            size_t pos = count[element[offset] ^ flip]++;
+            vec->copyElement(dst + (pos * sizeOfData), element, sizeOfData);
+        }
+
+        uint8_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != vec->data)
+    {
+        memcpy(vec->data, src, size * sizeOfData);
+    }
+
+    free(tmp);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_lowerBound(fdsa_vector *vec,
+                                               const void *key,
+                                               fdsa_cmpFunc cmp,
+                                               size_t *dst)
+{
+    if (!vec || !key || !cmp || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = fdsa_vector_search(vec->data, vec->size, vec->sizeOfData,
+                              key, cmp, false);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_upperBound(fdsa_vector *vec,
+                                               const void *key,
+                                               fdsa_cmpFunc cmp,
+                                               size_t *dst)
+{
+    if (!vec || !key || !cmp || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *dst = fdsa_vector_search(vec->data, vec->size, vec->sizeOfData,
+                              key, cmp, true);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_equalRange(fdsa_vector *vec,
+                                               const void *key,
+                                               fdsa_cmpFunc cmp,
+                                               size_t *first,
+                                               size_t *last)
+{
+    if (!vec || !key || !cmp || !first || !last)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    *first = fdsa_vector_search(vec->data, vec->size, vec->sizeOfData,
+                                key, cmp, false);
+
+    // the upper bound can only be found after the lower bound
+    size_t sizeOfData = vec->sizeOfData;
+    *last = *first + fdsa_vector_search(vec->data + (*first * sizeOfData),
+                                        vec->size - *first, sizeOfData,
+                                        key, cmp, true);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_vectorIndex *fdsa_vector_buildIndex(fdsa_vector *vec,
+                                                  fdsa_cmpFunc cmp)
+{
+    if (!vec || !cmp)
+    {
+        return NULL;
+    }
+
+    fdsa_vectorIndex *index = new (std::nothrow) fdsa_vectorIndex;
+    if (!index)
+    {
+        return NULL;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    index->size = vec->size;
+    index->sizeOfData = vec->sizeOfData;
+    index->cmp = cmp;
+    index->data = static_cast<uint8_t *>(
+        malloc((vec->size + 1) * vec->sizeOfData));
+    index->rank = static_cast<size_t *>(
+        malloc((vec->size + 1) * sizeof(size_t)));
+    if (!index->data || !index->rank)
+    {
+        fdsa_vector_destroyIndex(index);
+        return NULL;
+    }
+
+    fdsa_vectorIndex_build(index, vec->data, 0, 1);
+    return index;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_destroyIndex(fdsa_vectorIndex *index)
+{
+    if (!index) return fdsa_failed;
+
+    free(index->data);
+    free(index->rank);
+    delete index;
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_indexLowerBound(fdsa_vectorIndex *index,
+                                                    const void *key,
+                                                    size_t *dst)
+{
+    if (!index || !key || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    *dst = fdsa_vectorIndex_search(index, key, false);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_indexUpperBound(fdsa_vectorIndex *index,
+                                                    const void *key,
+                                                    size_t *dst)
+{
+    if (!index || !key || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    *dst = fdsa_vectorIndex_search(index, key, true);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_forEach(fdsa_vector *vec,
+                                            fdsa_vector_visitFunc func,
+                                            void *ctx)
+{
+    if (!vec || !func)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    const uint8_t *data = vec->data;
+    size_t size = vec->size;
+    size_t sizeOfData = vec->sizeOfData;
+    size_t chunk = fdsa_vector_chunkLength(sizeOfData);
+    fdsa_parallel_run((size + chunk - 1) / chunk, [&](size_t task)
+    {
+        size_t i = task * chunk;
+        size_t end = (size - i < chunk) ? size : i + chunk;
+        for (; i < end; ++i)
+        {
+            func(data + (i * sizeOfData), ctx);
+        }
+    });
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_transform(fdsa_vector *vec,
+                                              fdsa_vector_transformFunc func,
+                                              void *ctx)
+{
+    if (!vec || !func)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, 0) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    uint8_t *data = vec->data;
+    size_t size = vec->size;
+    size_t sizeOfData = vec->sizeOfData;
+    size_t chunk = fdsa_vector_chunkLength(sizeOfData);
+    fdsa_parallel_run((size + chunk - 1) / chunk, [&](size_t task)
+    {
+        size_t i = task * chunk;
+        size_t end = (size - i < chunk) ? size : i + chunk;
+        for (; i < end; ++i)
+        {
+            func(data + (i * sizeOfData), ctx);
+        }
+    });
+
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_reduce(fdsa_vector *vec,
+                                           const void *init,
+                                           size_t sizeOfAcc,
+                                           fdsa_vector_reduceFunc accumulate,
+                                           fdsa_vector_reduceFunc combine,
+                                           void *ctx,
+                                           void *dst)
+{
+    if (!vec || !init || !sizeOfAcc || !accumulate || !combine || !dst)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    const uint8_t *data = vec->data;
+    size_t size = vec->size;
+    size_t sizeOfData = vec->sizeOfData;
+    size_t chunk = fdsa_vector_chunkLength(sizeOfData);
+    size_t tasks = (size + chunk - 1) / chunk;
+    if (tasks < 2)
+    {
+        memcpy(dst, init, sizeOfAcc);
+        size_t i;
+        for (i = 0; i < size; ++i)
+        {
+            accumulate(dst, data + (i * sizeOfData), ctx);
+        }
+
+        return fdsa_success;
+    }
+
+    // one accumulator per chunk, each on its own cache lines
+    size_t stride = (sizeOfAcc + FDSA_CACHE_LINE - 1) /
+                    FDSA_CACHE_LINE * FDSA_CACHE_LINE;
+    uint8_t *acc = static_cast<uint8_t *>(malloc(tasks * stride));
+    if (!acc)
+    {
+        return fdsa_failed;
+    }
+
+    fdsa_parallel_run(tasks, [&](size_t task)
+    {
+        uint8_t *cur = acc + (task * stride);
+        memcpy(cur, init, sizeOfAcc);
+        size_t i = task * chunk;
+        size_t end = (size - i < chunk) ? size : i + chunk;
+        for (; i < end; ++i)
+        {
+            accumulate(cur, data + (i * sizeOfData), ctx);
+        }
+    });
+
+    // combine in chunk order, so the result does not depend on the workers
+    memcpy(dst, acc, sizeOfAcc);
+    size_t i;
+    for (i = 1; i < tasks; ++i)
+    {
+        combine(dst, acc + (i * stride), ctx);
+    }
+
+    free(acc);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_removeIf(fdsa_vector *vec,
+                                             fdsa_vector_predFunc pred,
+                                             void *ctx,
+                                             size_t *removed)
+{
+    if (!vec || !pred)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, 0) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    uint8_t *data = vec->data;
+    size_t size = vec->size;
+    size_t sizeOfData = vec->sizeOfData;
+    size_t i = 0;
+    while (i < size && !pred(data + (i * sizeOfData), ctx))
+    {
+        ++i;
+    }
+
+    // element i is removed, so out < i from here on: pred sees every
+    // element once and the copies never overlap
+    fdsa_vector_copyKernel copy = fdsa_vector_selectCopy(sizeOfData);
+    size_t out = i;
+    for (++i; i < size; ++i)
+    {
+        const uint8_t *src = data + (i * sizeOfData);
+        copy(data + (out * sizeOfData), src, sizeOfData);
+        out += !pred(src, ctx);
+    }
+
+    if (removed) *removed = size - out;
+    vec->size = out;
+    fdsa_vector_trimInternal(vec);
+    return fdsa_success;
+}
+
+FDSA_API fdsa_exitstate fdsa_vector_removeIfKey(fdsa_vector *vec,
+                                                size_t keyOffset,
+                                                size_t keySize,
+                                                int isSigned,
+                                                fdsa_vector_cmpOp op,
+                                                const void *value,
+                                                size_t *removed)
+{
+    if (!vec || !value || op < fdsa_vector_cmpLess ||
+        op > fdsa_vector_cmpGreaterEqual)
+    {
+        return fdsa_failed;
+    }
+
+    if (keySize != 1 && keySize != 2 && keySize != 4 && keySize != 8)
+    {
+        return fdsa_failed;
+    }
+
+    // the element size never changes, no need to hold the lock
+    size_t sizeOfData = vec->sizeOfData;
+    if (keyOffset > sizeOfData || keySize > sizeOfData - keyOffset)
+    {
+        return fdsa_failed;
+    }
+
+    std::lock_guard<fdsa_lock> lock(vec->lock);
+    if (fdsa_vector_readOnly(vec))
+    {
+        return fdsa_failed;
+    }
+
+    if (fdsa_vector_unshareInternal(vec, 0) == fdsa_failed)
+    {
+        return fdsa_failed;
+    }
+
+    size_t out;
+    unsigned bits = static_cast<unsigned>(op);
+    switch (keySize)
+    {
+    case 1:
+        out = isSigned ?
+              fdsa_vector_compactKeyOf<int8_t>(vec, keyOffset, value, bits) :
+              fdsa_vector_compactKeyOf<uint8_t>(vec, keyOffset, value, bits);
+        break;
+    case 2:
+        out = isSigned ?
+              fdsa_vector_compactKeyOf<int16_t>(vec, keyOffset, value, bits) :
+              fdsa_vector_compactKeyOf<uint16_t>(vec, keyOffset, value, bits);
+        break;
+    case 4:
+        out = isSigned ?
+              fdsa_vector_compactKeyOf<int32_t>(vec, keyOffset, value, bits) :
+              fdsa_vector_compactKeyOf<uint32_t>(vec, keyOffset, value, bits);
+        break;
+    case 8:
+        out = isSigned ?
+              fdsa_vector_compactKeyOf<int64_t>(vec, keyOffset, value, bits) :
+              fdsa_vector_compactKeyOf<uint64_t>(vec, keyOffset, value, bits);
+        break;
+    default:
+        return fdsa_failed;
+    }
+
+    if (removed) *removed = vec->size - out;
+    vec->size = out;
+    fdsa_vector_trimInternal(vec);
+    return fdsa_success;
+}
+
+} // end extern "C"
@@ -0,0 +1,370 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "vector.h"
+#include "vectorimpl.h"
+
+// On-disk layout written by fdsa_vector_save: the header below, zero
+// padding up to dataOffset, then the raw elements in native byte order.
+// Every mapping starts on a page, so alignments up to
+// FDSA_VECTOR_FILE_MAX_ALIGN survive fdsa_vector_openMapped.
+
+#define FDSA_VECTOR_FILE_MAGIC "fDSAvec"
+#define FDSA_VECTOR_FILE_VERSION 1
+#define FDSA_VECTOR_FILE_BYTE_ORDER 0x01020304u
+#define FDSA_VECTOR_FILE_MAX_ALIGN 4096
+
+typedef struct fdsa_vector_fileHeader
+{
+    char magic[8];
+
+    uint32_t version;
+
+    uint32_t byteOrder; // reads back swapped on the other endianness
+
+    uint64_t sizeOfData;
+
+    uint64_t size;
+
+    uint64_t alignment;
+
+    uint64_t dataOffset; // a multiple of alignment
+
+    uint64_t checksum; // fdsa_vector_checksum of the elements
+
+    uint64_t reserved;
+} fdsa_vector_fileHeader;
+
+static_assert(sizeof(fdsa_vector_fileHeader) == 64,
+              "fdsa_vector_fileHeader is part of the file format");
+
+#define FDSA_VECTOR_KNOWN_OPEN_FLAGS \
+    (fdsa_vector_lockMask | fdsa_vector_verifyChecksum)
+
+// FNV-1a over 64-bit words, the last partial word is zero padded
+static uint64_t fdsa_vector_checksum(const uint8_t *data, size_t bytes)
+{
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t ret = 14695981039346656037ULL;
+    uint64_t word;
+    size_t i;
+    for (i = 0; i + sizeof(word) <= bytes; i += sizeof(word))
+    {
+        memcpy(&word, data + i, sizeof(word));
+        ret = (ret ^ word) * prime;
+    }
+
+    if (i < bytes)
+    {
+        word = 0;
+        memcpy(&word, data + i, bytes - i);
+        ret = (ret ^ word) * prime;
+    }
+
+    return ret;
+}
+
+// Map the whole file read-only, returns NULL on failure.
+static uint8_t *fdsa_vector_mapFile(const char *path, size_t *bytes)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    uint64_t fileBytes = static_cast<uint64_t>(fileSize.QuadPart);
+    if (fileBytes < sizeof(fdsa_vector_fileHeader) || fileBytes > SIZE_MAX)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        return NULL;
+    }
+
+    // the view keeps the mapping object alive
+    void *ret = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!ret)
+    {
+        return NULL;
+    }
+
+    *bytes = static_cast<size_t>(fileBytes);
+    return static_cast<uint8_t *>(ret);
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    uint64_t fileBytes = static_cast<uint64_t>(info.st_size);
+    if (fileBytes < sizeof(fdsa_vector_fileHeader) || fileBytes > SIZE_MAX)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    size_t fileSize = static_cast<size_t>(fileBytes);
+    void *ret = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ret == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    *bytes = fileSize;
+    return static_cast<uint8_t *>(ret);
+#endif
+}
+
+// caller must hold vec->lock
+void fdsa_vector_unmapFile(fdsa_vector *vec)
+{
+    if (!vec->file) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(vec->file);
+#else
+    munmap(vec->file, vec->fileBytes);
+#endif
+    vec->file = NULL;
+    vec->fileBytes = 0;
+}
+
+static bool fdsa_vector_checkHeader(const fdsa_vector_fileHeader *header,
+                                    size_t fileBytes)
+{
+    uint64_t alignment = header->alignment;
+    if (memcmp(header->magic, FDSA_VECTOR_FILE_MAGIC, sizeof(header->magic)) ||
+        header->version != FDSA_VECTOR_FILE_VERSION ||
+        header->byteOrder != FDSA_VECTOR_FILE_BYTE_ORDER ||
+        !header->sizeOfData ||
+        !alignment || (alignment & (alignment - 1)) ||
+        alignment > FDSA_VECTOR_FILE_MAX_ALIGN ||
+        header->dataOffset < sizeof(fdsa_vector_fileHeader) ||
+        (header->dataOffset & (alignment - 1)) ||
+        header->dataOffset > fileBytes)
+    {
+        return false;
+    }
+
+    // the elements must fit in the file
+    uint64_t room = fileBytes - header->dataOffset;
+    return header->size <= room / header->sizeOfData;
+}
+
+extern "C"
+{
+
+FDSA_API fdsa_exitstate fdsa_vector_save(fdsa_vector *vec, const char *path)
+{
+    if (!vec || !path)
+    {
+        return fdsa_failed;
+    }
+
+    std::shared_lock<fdsa_lock> lock(vec->lock);
+    if (vec->alignment > FDSA_VECTOR_FILE_MAX_ALIGN)
+    {
+        return fdsa_failed;
+    }
+
+    size_t bytes = vec->size * vec->sizeOfData;
+    fdsa_vector_fileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FDSA_VECTOR_FILE_MAGIC, sizeof(header.magic));
+    header.version = FDSA_VECTOR_FILE_VERSION;
+    header.byteOrder = FDSA_VECTOR_FILE_BYTE_ORDER;
+    header.sizeOfData = vec->sizeOfData;
+    header.size = vec->size;
+    header.alignment = vec->alignment;
+    header.dataOffset = (vec->alignment > sizeof(header)) ?
+                        vec->alignment : sizeof(header);
+    header.checksum = fdsa_vector_checksum(vec->data, bytes);
+
+    // Write a temporary file and rename it over path, so that a mapping of
+    // path, even the source of this save, never sees a truncated file and
+    // a failed save keeps the previous file.
+    size_t pathLen = strlen(path);
+    char *tmpPath = new (std::nothrow) char[pathLen + sizeof(".tmp")];
+    if (!tmpPath)
+    {
+        return fdsa_failed;
+    }
+
+    memcpy(tmpPath, path, pathLen);
+    memcpy(tmpPath + pathLen, ".tmp", sizeof(".tmp"));
+
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file)
+    {
+        delete[] tmpPath;
+        return fdsa_failed;
+    }
+
+    static const uint8_t zero[sizeof(header)] = {0};
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    size_t padding = header.dataOffset - sizeof(header);
+    while (ok && padding)
+    {
+        size_t len = (padding < sizeof(zero)) ? padding : sizeof(zero);
+        ok = (fwrite(zero, 1, len, file) == len);
+        padding -= len;
+    }
+
+    if (ok && bytes)
+    {
+        ok = (fwrite(vec->data, 1, bytes, file) == bytes);
+    }
+
+    ok = ok && !fflush(file);
+#ifdef _WIN32
+    ok = ok && FlushFileBuffers(
+        reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file))));
+#else
+    ok = ok && !fsync(fileno(file));
+#endif
+
+    if (fclose(file) || !ok)
+    {
+        remove(tmpPath);
+        delete[] tmpPath;
+        return fdsa_failed;
+    }
+
+#ifdef _WIN32
+    ok = MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = !rename(tmpPath, path);
+#endif
+
+    if (!ok)
+    {
+        remove(tmpPath);
+    }
+
+    delete[] tmpPath;
+    return ok ? fdsa_success : fdsa_failed;
+}
+
+FDSA_API fdsa_vector *fdsa_vector_openMapped(const char *path, unsigned flags)
+{
+    if (!path || (flags & ~FDSA_VECTOR_KNOWN_OPEN_FLAGS))
+    {
+        return NULL;
+    }
+
+    fdsa_lockPolicy policy;
+    if (fdsa_lock_policyFromFlags(flags, &policy) == fdsa_failed)
+    {
+        return NULL;
+    }
+
+    size_t fileBytes = 0;
+    uint8_t *file = fdsa_vector_mapFile(path, &fileBytes);
+    if (!file)
+    {
+        return NULL;
+    }
+
+    fdsa_vector_fileHeader header;
+    memcpy(&header, file, sizeof(header));
+    fdsa_vector *vec = NULL;
+    if (fdsa_vector_checkHeader(&header, fileBytes))
+    {
+        vec = new (std::nothrow) fdsa_vector;
+    }
+
+    if (!vec)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(file);
+#else
+        munmap(file, fileBytes);
+#endif
+        return NULL;
+    }
+
+    vec->file = file;
+    vec->fileBytes = fileBytes;
+    vec->storage = fdsa_vector_storageFile;
+    vec->data = file + header.dataOffset;
+    vec->sizeOfData = static_cast<size_t>(header.sizeOfData);
+    vec->copyElement = fdsa_vector_selectCopy(vec->sizeOfData);
+    vec->alignment = static_cast<size_t>(header.alignment);
+    vec->size = static_cast<size_t>(header.size);
+    vec->capacity = vec->size;
+    vec->bytes = vec->size * vec->sizeOfData;
+    vec->lock.policy = policy;
+
+    if ((flags & fdsa_vector_verifyChecksum) &&
+        fdsa_vector_checksum(vec->data, vec->bytes) != header.checksum)
+    {
+        fdsa_vector_destroy(vec);
+        return NULL;
+    }
+
+    return vec;
+}
+
+} // end extern "C"
@@ -0,0 +1,147 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "lock.h"
+#include "vectorkernel.h"
+
+#include "include/internal/vector.h"
+
+// Definition of fdsa_vector shared by its translation units.
+
+// buffers at least this large are mapped directly on Linux,
+// so that growth can move pages with mremap instead of copying bytes
+#define FDSA_VECTOR_MAP_THRESHOLD (static_cast<size_t>(1) << 20)
+
+// alignment that malloc already guarantees
+#define FDSA_VECTOR_HEAP_ALIGN alignof(std::max_align_t)
+
+// bytes of elements stored inside the object with fdsa_vector_inlineStorage
+#define FDSA_VECTOR_INLINE_BYTES 64
+
+// mapping unit of fdsa_vector_hugePages, the PMD size of x86-64 and arm64
+#define FDSA_VECTOR_HUGE_PAGE (static_cast<size_t>(2) << 20)
+
+#define FDSA_VECTOR_KNOWN_FLAGS \
+    (fdsa_vector_lockMask | fdsa_vector_inlineStorage | \
+     fdsa_vector_hugePages | fdsa_vector_hugeTLB)
+
+typedef enum fdsa_vector_storage
+{
+    fdsa_vector_storageHeap, /**< malloc / realloc / free */
+    fdsa_vector_storageAligned, /**< aligned allocation, no realloc */
+    fdsa_vector_storageInline, /**< inlineData, never freed */
+    fdsa_vector_storageMapped, /**< mmap / mremap / munmap */
+    fdsa_vector_storageFile, /**< read-only file mapping, see vectorfile.cpp */
+    fdsa_vector_storageAdopted, /**< caller buffer, freed by dealloc */
+    fdsa_vector_storageShared /**< read-only snapshot of another vector */
+} fdsa_vector_storage;
+
+// Buffer shared between a vector and its snapshots. owner is a vector
+// object that only holds the buffer, the last reference destroys it.
+typedef struct fdsa_vectorShared
+{
+    std::atomic<size_t> refs{0};
+
+    fdsa_vector *owner = NULL;
+} fdsa_vectorShared;
+
+typedef struct fdsa_vector
+{
+    uint8_t *data = NULL;
+
+    size_t bytes = 0; // allocated bytes of data
+
+    fdsa_vector_storage storage = fdsa_vector_storageHeap;
+
+    size_t alignment = FDSA_VECTOR_HEAP_ALIGN;
+
+    size_t sizeOfData = 0;
+
+    fdsa_vector_copyKernel copyElement = fdsa_vector_copyGeneric;
+
+    size_t size = 0;
+
+    size_t capacity = 0;
+
+    double growthFactor = 2.0;
+
+    size_t growthMinStep = 4;
+
+    size_t growthMaxStep = 0; // 0 means unbounded
+
+    double trimThreshold = 0.0; // 0 means the trim policy is off
+
+    size_t trimMinCapacity = 0;
+
+    size_t inlineCapacity = 0; // 0 when inline storage is off
+
+    bool hugePages = false; // fdsa_vector_hugePages or fdsa_vector_hugeTLB
+
+    bool hugeTLB = false; // try MAP_HUGETLB first
+
+    bool mappedTLB = false; // the current mapping came from MAP_HUGETLB
+
+    void *file = NULL; // whole file mapping with fdsa_vector_storageFile
+
+    fdsa_vector_deallocFunc dealloc = NULL; // fdsa_vector_storageAdopted
+
+    void *deallocCtx = NULL;
+
+    fdsa_vectorShared *shared = NULL; // set while snapshots share data
+
+    size_t sharedSize = 0; // elements the snapshots of data can see
+
+    size_t fileBytes = 0;
+
+    fdsa_lock lock;
+
+    alignas(FDSA_VECTOR_HEAP_ALIGN)
+    uint8_t inlineData[FDSA_VECTOR_INLINE_BYTES];
+} fdsa_vector;
+
+// Mapped files and snapshots cannot be modified.
+// caller must hold vec->lock
+static inline bool fdsa_vector_readOnly(const fdsa_vector *vec)
+{
+    return vec->storage == fdsa_vector_storageFile ||
+           vec->storage == fdsa_vector_storageShared;
+}
+
+// Release the file mapping of fdsa_vector_storageFile.
+// caller must hold vec->lock
+void fdsa_vector_unmapFile(fdsa_vector *vec);
+
+// Apply the trim policy after the size went down.
+// caller must hold vec->lock
+void fdsa_vector_trimInternal(fdsa_vector *vec);
+
+// Copy the buffer if a snapshot can still see the elements from first on,
+// call it before writing to them.
+// caller must hold vec->lock
+fdsa_exitstate fdsa_vector_unshareInternal(fdsa_vector *vec, size_t first);
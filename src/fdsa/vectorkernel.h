@@ -0,0 +1,120 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Element kernels of fdsa_vector.
+// The element size is only known at runtime, so the vector picks a kernel
+// specialized for its size when it is created. For the common widths the
+// copy length is a constant and compiles to plain loads and stores.
+
+typedef void (*fdsa_vector_copyKernel)(uint8_t *dst,
+                                       const uint8_t *src,
+                                       size_t sizeOfData);
+
+template<size_t width>
+static void fdsa_vector_copyFixed(uint8_t *dst, const uint8_t *src, size_t)
+{
+    memcpy(dst, src, width);
+}
+
+static void fdsa_vector_copyGeneric(uint8_t *dst,
+                                    const uint8_t *src,
+                                    size_t sizeOfData)
+{
+    memcpy(dst, src, sizeOfData);
+}
+
+static inline fdsa_vector_copyKernel fdsa_vector_selectCopy(size_t sizeOfData)
+{
+    switch (sizeOfData)
+    {
+    case 1:
+        return fdsa_vector_copyFixed<1>;
+    case 2:
+        return fdsa_vector_copyFixed<2>;
+    case 4:
+        return fdsa_vector_copyFixed<4>;
+    case 8:
+        return fdsa_vector_copyFixed<8>;
+    case 16:
+        return fdsa_vector_copyFixed<16>;
+    case 32:
+        return fdsa_vector_copyFixed<32>;
+    default:
+        return fdsa_vector_copyGeneric;
+    }
+}
+
+// Fill count elements at dst with the element at src.
+// Power-of-two widths up to 32 bytes broadcast the element into a 32-byte
+// block and store whole blocks, which the compiler emits as vector stores.
+// Other widths copy the first element and then double the filled prefix
+// with memcpy, so the fill takes O(log count) memcpy calls.
+static inline void fdsa_vector_patternFill(uint8_t *dst,
+                                           const uint8_t *src,
+                                           size_t count,
+                                           size_t sizeOfData)
+{
+    if (!count) return;
+
+    size_t total = count * sizeOfData;
+    if (sizeOfData == 1)
+    {
+        memset(dst, src[0], total);
+        return;
+    }
+
+    if (sizeOfData <= 32 && !(sizeOfData & (sizeOfData - 1)))
+    {
+        uint8_t block[32];
+        size_t i;
+        for (i = 0; i < 32; i += sizeOfData)
+        {
+            memcpy(block + i, src, sizeOfData);
+        }
+
+        uint8_t *end = dst + (total & ~static_cast<size_t>(31));
+        for (; dst < end; dst += 32)
+        {
+            memcpy(dst, block, 32);
+        }
+
+        // the tail is a whole number of elements
+        memcpy(dst, block, total & 31);
+        return;
+    }
+
+    memcpy(dst, src, sizeOfData);
+    size_t filled = sizeOfData;
+    while (filled < total)
+    {
+        size_t len = (filled < total - filled) ? filled : (total - filled);
+        memcpy(dst + filled, dst, len);
+        filled += len;
+    }
+}
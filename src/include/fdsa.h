@@ -23,10 +23,13 @@
 
 #pragma once
 
+#include "internal/columnvector.h"
+#include "internal/concurrentvector.h"
 #include "internal/defines.h"
 #include "internal/ptrlinkedlist.h"
 #include "internal/ptrmap.h"
 #include "internal/ptrvector.h"
+#include "internal/segmentedvector.h"
 #include "internal/vector.h"
 
 #ifdef __cplusplus
@@ -41,12 +44,18 @@ extern "C"
  */
 typedef struct fDSA
 {
+    fdsa_columnVector_api columnVector;
+
+    fdsa_concurrentVector_api concurrentVector;
+
     fdsa_ptrLinkedList_api ptrLinkedList;
 
     fdsa_ptrMap_api ptrMap;
 
     fdsa_ptrVector_api ptrVector;
 
+    fdsa_segmentedVector_api segmentedVector;
+
     fdsa_vector_api vector;
 
     /**
@@ -0,0 +1,162 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "defines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @struct fdsa_columnVector
+ * A vector of rows stored column by column (struct of arrays).
+ * Each column is a separate fdsa_vector buffer, so a scan over one field
+ * only reads that field. Rows are passed in and out as structs, described
+ * by the size and offset of every column.
+ */
+typedef struct fdsa_columnVector fdsa_columnVector;
+
+typedef struct fdsa_columnVector_api
+{
+    fdsa_columnVector *(*create)(size_t columns,
+                                 const size_t *sizes,
+                                 const size_t *offsets);
+
+    fdsa_columnVector *(*createEx)(size_t columns,
+                                   const size_t *sizes,
+                                   const size_t *offsets,
+                                   unsigned flags);
+
+    fdsa_exitstate (*destory)(fdsa_columnVector *vector);
+
+    fdsa_exitstate (*at)(fdsa_columnVector *vector, size_t index, void *row);
+
+    fdsa_exitstate (*setValue)(fdsa_columnVector *vector,
+                               size_t index,
+                               const void *row);
+
+    fdsa_exitstate (*field)(fdsa_columnVector *vector,
+                            size_t column,
+                            size_t index,
+                            void *dst);
+
+    fdsa_exitstate (*setField)(fdsa_columnVector *vector,
+                               size_t column,
+                               size_t index,
+                               const void *src);
+
+    fdsa_exitstate (*pushBack)(fdsa_columnVector *vector, const void *row);
+
+    fdsa_exitstate (*clear)(fdsa_columnVector *vector);
+
+    fdsa_exitstate (*size)(fdsa_columnVector *vector, size_t *dst);
+
+    fdsa_exitstate (*capacity)(fdsa_columnVector *vector, size_t *dst);
+
+    fdsa_exitstate (*reserve)(fdsa_columnVector *vector, size_t newSize);
+
+    fdsa_exitstate (*columnCount)(fdsa_columnVector *vector, size_t *dst);
+
+    const void *(*columnData)(fdsa_columnVector *vector, size_t column);
+} fdsa_columnVector_api;
+
+/**
+ * @param columns number of columns, > 0
+ * @param sizes size in bytes of every column
+ * @param offsets offset of every column in a row, for example offsetof of
+ *        the fields of a struct. NULL means the columns are packed in order.
+ */
+FDSA_API fdsa_columnVector *fdsa_columnVector_create(size_t columns,
+                                                     const size_t *sizes,
+                                                     const size_t *offsets);
+
+/**
+ * @param flags lock flags of fdsa_vector_flag
+ */
+FDSA_API fdsa_columnVector *fdsa_columnVector_createEx(size_t columns,
+                                                       const size_t *sizes,
+                                                       const size_t *offsets,
+                                                       unsigned flags);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_destroy(fdsa_columnVector *vector);
+
+/**
+ * Gather the row at index from every column.
+ */
+FDSA_API fdsa_exitstate fdsa_columnVector_at(fdsa_columnVector *vector,
+                                             size_t index,
+                                             void *row);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_setValue(fdsa_columnVector *vector,
+                                                   size_t index,
+                                                   const void *row);
+
+/**
+ * Read a single field, dst receives sizes[column] bytes.
+ */
+FDSA_API fdsa_exitstate fdsa_columnVector_field(fdsa_columnVector *vector,
+                                                size_t column,
+                                                size_t index,
+                                                void *dst);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_setField(fdsa_columnVector *vector,
+                                                   size_t column,
+                                                   size_t index,
+                                                   const void *src);
+
+/**
+ * Scatter row into every column.
+ */
+FDSA_API fdsa_exitstate fdsa_columnVector_pushBack(fdsa_columnVector *vector,
+                                                   const void *row);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_clear(fdsa_columnVector *vector);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_size(fdsa_columnVector *vector,
+                                               size_t *dst);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_capacity(fdsa_columnVector *vector,
+                                                   size_t *dst);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_reserve(fdsa_columnVector *vector,
+                                                  size_t newSize);
+
+FDSA_API fdsa_exitstate fdsa_columnVector_columnCount(
+        fdsa_columnVector *vector,
+        size_t *dst);
+
+/**
+ * The contiguous values of one column, aligned on 64 bytes.
+ * The pointer is valid until the vector grows.
+ */
+FDSA_API const void *fdsa_columnVector_columnData(fdsa_columnVector *vector,
+                                                  size_t column);
+
+#ifdef __cplusplus
+}
+#endif
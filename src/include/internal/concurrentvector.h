@@ -0,0 +1,145 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "defines.h"
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @struct fdsa_concurrentVector
+ * An append-only vector for many producers.
+ * Producers claim slots with an atomic fetch-add and write them without
+ * any lock. Storage is segmented, so an element never moves once its
+ * slot is claimed. Readers only see the prefix of published elements.
+ */
+typedef struct fdsa_concurrentVector fdsa_concurrentVector;
+
+typedef struct fdsa_concurrentVector_api
+{
+    fdsa_concurrentVector *(*create)(size_t sizeOfData);
+
+    fdsa_exitstate (*destory)(fdsa_concurrentVector *vector);
+
+    fdsa_exitstate (*claim)(fdsa_concurrentVector *vector,
+                            size_t count,
+                            size_t *first);
+
+    void *(*slot)(fdsa_concurrentVector *vector, size_t index);
+
+    fdsa_exitstate (*publish)(fdsa_concurrentVector *vector,
+                              size_t first,
+                              size_t count);
+
+    fdsa_exitstate (*pushBack)(fdsa_concurrentVector *vector,
+                               const void *src);
+
+    fdsa_exitstate (*append)(fdsa_concurrentVector *vector,
+                             const void *dataArray,
+                             size_t dataLen);
+
+    fdsa_exitstate (*at)(fdsa_concurrentVector *vector,
+                         size_t index,
+                         void *dst);
+
+    fdsa_exitstate (*size)(fdsa_concurrentVector *vector, size_t *dst);
+
+    fdsa_vector *(*toVector)(fdsa_concurrentVector *vector);
+} fdsa_concurrentVector_api;
+
+FDSA_API fdsa_concurrentVector *fdsa_concurrentVector_create(
+        size_t sizeOfData);
+
+/**
+ * No other thread may use the vector while it is destroyed.
+ */
+FDSA_API fdsa_exitstate fdsa_concurrentVector_destroy(
+        fdsa_concurrentVector *vector);
+
+/**
+ * Claim count consecutive slots, the first index is stored in first.
+ * The slots must be written through slot() and then published.
+ * If a segment allocation fails after the slots were reserved, the claim
+ * fails and its slots are published as zero-filled elements, so the
+ * elements claimed after it still become visible.
+ */
+FDSA_API fdsa_exitstate fdsa_concurrentVector_claim(
+        fdsa_concurrentVector *vector,
+        size_t count,
+        size_t *first);
+
+/**
+ * @return the address of a claimed slot, it stays valid until the
+ *         vector is destroyed.
+ */
+FDSA_API void *fdsa_concurrentVector_slot(fdsa_concurrentVector *vector,
+                                          size_t index);
+
+/**
+ * Mark claimed slots as fully written.
+ */
+FDSA_API fdsa_exitstate fdsa_concurrentVector_publish(
+        fdsa_concurrentVector *vector,
+        size_t first,
+        size_t count);
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_pushBack(
+        fdsa_concurrentVector *vector,
+        const void *src);
+
+FDSA_API fdsa_exitstate fdsa_concurrentVector_append(
+        fdsa_concurrentVector *vector,
+        const void *dataArray,
+        size_t dataLen);
+
+/**
+ * Only elements below size() can be read.
+ */
+FDSA_API fdsa_exitstate fdsa_concurrentVector_at(
+        fdsa_concurrentVector *vector,
+        size_t index,
+        void *dst);
+
+/**
+ * @param dst the number of leading elements that are all published
+ */
+FDSA_API fdsa_exitstate fdsa_concurrentVector_size(
+        fdsa_concurrentVector *vector,
+        size_t *dst);
+
+/**
+ * Copy the published elements into a new contiguous fdsa_vector.
+ */
+FDSA_API fdsa_vector *fdsa_concurrentVector_toVector(
+        fdsa_concurrentVector *vector);
+
+#ifdef __cplusplus
+}
+#endif
@@ -35,6 +35,35 @@ extern "C"
 
 typedef struct fdsa_ptrVector fdsa_ptrVector;
 
+/**
+ * @typedef fdsa_ptrVector_predFunc
+ * Returns non-zero if fdsa_ptrVector_removeIf should remove the element.
+ */
+typedef int (*fdsa_ptrVector_predFunc)(const void *element, void *ctx);
+
+/**
+ * @enum fdsa_ptrVector_reclaimMode
+ * How clear and destroy release the elements.
+ */
+typedef enum fdsa_ptrVector_reclaimMode
+{
+    fdsa_ptrVector_reclaimInline = 0, /**< freeFunc runs on the calling
+                                           thread, the default */
+    fdsa_ptrVector_reclaimParallel = 1, /**< freeFunc runs on worker threads
+                                             after the lock is released */
+    fdsa_ptrVector_reclaimDeferred = 2 /**< freeFunc runs on a background
+                                            reclaimer thread */
+} fdsa_ptrVector_reclaimMode;
+
+/**
+ * @typedef fdsa_ptrVector_visitFunc
+ * Called once per element by fdsa_ptrVector_forEach.
+ * Return non-zero to stop the iteration.
+ */
+typedef int (*fdsa_ptrVector_visitFunc)(void *element,
+                                        size_t index,
+                                        void *ctx);
+
 typedef struct fdsa_ptrVector_api
 {
     fdsa_ptrVector *(*create)(fdsa_freeFunc freeFunc);
@@ -57,10 +86,43 @@ typedef struct fdsa_ptrVector_api
 
     fdsa_exitstate (*pushBack)(fdsa_ptrVector *ptrVector, void *src);
 
+    fdsa_exitstate (*pushBackN)(fdsa_ptrVector *ptrVector,
+                                void **src,
+                                size_t count);
+
     fdsa_exitstate (*resize)(fdsa_ptrVector *vector,
                              size_t newSize,
                              void *src,
                              void *(*deepCopyFunc)(void *));
+
+    fdsa_exitstate (*swapRemove)(fdsa_ptrVector *ptrVector, size_t index);
+
+    fdsa_exitstate (*eraseAt)(fdsa_ptrVector *ptrVector, size_t index);
+
+    fdsa_exitstate (*eraseRange)(fdsa_ptrVector *ptrVector,
+                                 size_t first,
+                                 size_t count);
+
+    fdsa_exitstate (*removeIf)(fdsa_ptrVector *ptrVector,
+                               fdsa_ptrVector_predFunc pred,
+                               void *ctx,
+                               size_t *removed);
+
+    fdsa_exitstate (*forEach)(fdsa_ptrVector *ptrVector,
+                              fdsa_ptrVector_visitFunc func,
+                              void *ctx,
+                              size_t prefetchDistance);
+
+    fdsa_exitstate (*shrinkToFit)(fdsa_ptrVector *ptrVector);
+
+    fdsa_exitstate (*setTrimPolicy)(fdsa_ptrVector *ptrVector,
+                                    double threshold,
+                                    size_t minCapacity);
+
+    fdsa_exitstate (*setReclaimMode)(fdsa_ptrVector *ptrVector,
+                                     unsigned mode);
+
+    fdsa_exitstate (*flush)(fdsa_ptrVector *ptrVector);
 } fdsa_ptrVector_api;
 
 FDSA_API fdsa_ptrVector *fdsa_ptrVector_create(fdsa_freeFunc freeFunc);
@@ -87,11 +149,102 @@ FDSA_API fdsa_exitstate fdsa_ptrVector_reserve(fdsa_ptrVector *ptrVector,
 FDSA_API fdsa_exitstate fdsa_ptrVector_pushBack(fdsa_ptrVector *ptrVector,
                                                 void *src);
 
+/**
+ * Append count pointers from src under one lock and one growth step.
+ * The vector takes ownership of the pointers only on success.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_pushBackN(fdsa_ptrVector *ptrVector,
+                                                 void **src,
+                                                 size_t count);
+
+/**
+ * Shrink, freeing the removed elements, or grow with deep copies of src.
+ * A large growth calls deepCopyFunc on several threads at once, up to the
+ * hardware thread count or FDSA_THREADS if lower. If a copy
+ * returns NULL, the copies made so far are freed and the vector is left
+ * at its old size.
+ */
 FDSA_API fdsa_exitstate fdsa_ptrVector_resize(fdsa_ptrVector *vector,
                                               size_t newSize,
                                               void *src,
                                               void *(*deepCopyFunc)(void *));
 
+/**
+ * Remove the element at index in O(1) by moving the last element into
+ * its slot. The removed element is freed after the lock is released.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_swapRemove(fdsa_ptrVector *ptrVector,
+                                                  size_t index);
+
+/**
+ * Same as fdsa_ptrVector_swapRemove, but later elements move down.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_eraseAt(fdsa_ptrVector *ptrVector,
+                                               size_t index);
+
+/**
+ * Remove the elements [first, first + count), later elements move down.
+ * The removed elements are freed according to the reclaim mode.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_eraseRange(fdsa_ptrVector *ptrVector,
+                                                  size_t first,
+                                                  size_t count);
+
+/**
+ * Remove every element for which pred returns non-zero in one pass,
+ * the kept elements keep their order. The removed elements are freed
+ * according to the reclaim mode, pred runs under the lock.
+ * @param removed receives the number of removed elements, may be NULL
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_removeIf(fdsa_ptrVector *ptrVector,
+                                                fdsa_ptrVector_predFunc pred,
+                                                void *ctx,
+                                                size_t *removed);
+
+/**
+ * Visit the elements in order under a single lock, func must not call
+ * back into the same vector.
+ * @param prefetchDistance prefetch the pointee this many elements ahead,
+ *        0 disables prefetching. 8 to 16 suits most heap objects.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_forEach(fdsa_ptrVector *ptrVector,
+                                               fdsa_ptrVector_visitFunc func,
+                                               void *ctx,
+                                               size_t prefetchDistance);
+
+/**
+ * Reduce the capacity to the size, releasing the array if it is empty.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_shrinkToFit(fdsa_ptrVector *ptrVector);
+
+/**
+ * Same policy as fdsa_vector_setTrimPolicy, applied after clear, after
+ * removals and after resize shrinks the vector.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_setTrimPolicy(fdsa_ptrVector *ptrVector,
+                                                     double threshold,
+                                                     size_t minCapacity);
+
+/**
+ * In the parallel and deferred modes, clear and destroy swap the pointer
+ * array out in O(1) and call freeFunc after the lock is released, so
+ * freeFunc must be thread safe. clear then also releases the array.
+ * eraseRange and removeIf hand their removed elements over the same way.
+ * The parallel mode uses as many threads as fdsa_ptrVector_resize.
+ * @param mode one of fdsa_ptrVector_reclaimMode
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_setReclaimMode(fdsa_ptrVector *ptrVector,
+                                                      unsigned mode);
+
+/**
+ * Wait until the reclaimer has freed every element that ptrVector handed
+ * to it, NULL waits for those of every vector, destroyed ones included.
+ * The reclaimer frees what is still queued when the process exits or the
+ * library is unloaded, elements handed to it after that are freed on the
+ * calling thread. A forked child frees its copy of the queue itself.
+ */
+FDSA_API fdsa_exitstate fdsa_ptrVector_flush(fdsa_ptrVector *ptrVector);
+
 #ifdef __cplusplus
 }
 #endif
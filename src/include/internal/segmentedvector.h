@@ -0,0 +1,190 @@
+/*
+ * This file is part of fDSA,
+ * Copyright(C) 2019-2021 fdar0536.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "defines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @struct fdsa_segmentedVector
+ * A vector of fixed-size elements stored in geometrically sized segments
+ * found through a small directory. Indexed access is O(1) and growth
+ * never moves an element, so element addresses stay valid until the
+ * vector is destroyed.
+ */
+typedef struct fdsa_segmentedVector fdsa_segmentedVector;
+
+typedef struct fdsa_segmentedVector_api
+{
+    fdsa_segmentedVector *(*create)(size_t sizeOfData);
+
+    fdsa_segmentedVector *(*createEx)(size_t sizeOfData, unsigned flags);
+
+    fdsa_exitstate (*destory)(fdsa_segmentedVector *vector);
+
+    fdsa_exitstate (*at)(fdsa_segmentedVector *vector,
+                         size_t index,
+                         void *dst);
+
+    fdsa_exitstate (*setValue)(fdsa_segmentedVector *vector,
+                               size_t index,
+                               const void *src);
+
+    fdsa_exitstate (*atRange)(fdsa_segmentedVector *vector,
+                              size_t first,
+                              size_t count,
+                              void *dst);
+
+    fdsa_exitstate (*setRange)(fdsa_segmentedVector *vector,
+                               size_t first,
+                               size_t count,
+                               const void *src);
+
+    fdsa_exitstate (*clear)(fdsa_segmentedVector *vector);
+
+    fdsa_exitstate (*size)(fdsa_segmentedVector *vector, size_t *dst);
+
+    fdsa_exitstate (*capacity)(fdsa_segmentedVector *vector, size_t *dst);
+
+    fdsa_exitstate (*reserve)(fdsa_segmentedVector *vector, size_t newSize);
+
+    fdsa_exitstate (*pushBack)(fdsa_segmentedVector *vector,
+                               const void *src);
+
+    fdsa_exitstate (*resize)(fdsa_segmentedVector *vector,
+                             size_t newSize,
+                             const void *src);
+
+    fdsa_exitstate (*append)(fdsa_segmentedVector *vector,
+                             const void *dataArray,
+                             size_t dataLen);
+
+    void *(*address)(fdsa_segmentedVector *vector, size_t index);
+
+    fdsa_exitstate (*segmentCount)(fdsa_segmentedVector *vector,
+                                   size_t *dst);
+
+    const void *(*segment)(fdsa_segmentedVector *vector,
+                           size_t segment,
+                           size_t *length);
+} fdsa_segmentedVector_api;
+
+FDSA_API fdsa_segmentedVector *fdsa_segmentedVector_create(size_t sizeOfData);
+
+/**
+ * @param flags lock flags of fdsa_vector_flag
+ */
+FDSA_API fdsa_segmentedVector *fdsa_segmentedVector_createEx(
+        size_t sizeOfData,
+        unsigned flags);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_destroy(
+        fdsa_segmentedVector *vector);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_at(fdsa_segmentedVector *vector,
+                                                size_t index,
+                                                void *dst);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_setValue(
+        fdsa_segmentedVector *vector,
+        size_t index,
+        const void *src);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_atRange(
+        fdsa_segmentedVector *vector,
+        size_t first,
+        size_t count,
+        void *dst);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_setRange(
+        fdsa_segmentedVector *vector,
+        size_t first,
+        size_t count,
+        const void *src);
+
+/**
+ * Set size to 0, the segments are kept.
+ */
+FDSA_API fdsa_exitstate fdsa_segmentedVector_clear(
+        fdsa_segmentedVector *vector);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_size(
+        fdsa_segmentedVector *vector,
+        size_t *dst);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_capacity(
+        fdsa_segmentedVector *vector,
+        size_t *dst);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_reserve(
+        fdsa_segmentedVector *vector,
+        size_t newSize);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_pushBack(
+        fdsa_segmentedVector *vector,
+        const void *src);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_resize(
+        fdsa_segmentedVector *vector,
+        size_t newSize,
+        const void *src);
+
+FDSA_API fdsa_exitstate fdsa_segmentedVector_append(
+        fdsa_segmentedVector *vector,
+        const void *dataArray,
+        size_t dataLen);
+
+/**
+ * @return the address of an element, it stays valid until the vector is
+ *         destroyed. Accessing it is not protected by the vector's lock.
+ */
+FDSA_API void *fdsa_segmentedVector_address(fdsa_segmentedVector *vector,
+                                            size_t index);
+
+/**
+ * @param dst the number of segments that hold elements
+ */
+FDSA_API fdsa_exitstate fdsa_segmentedVector_segmentCount(
+        fdsa_segmentedVector *vector,
+        size_t *dst);
+
+/**
+ * Get a segment for streaming scans.
+ * @param length the number of elements of the segment in use
+ * @return the first element of the segment
+ */
+FDSA_API const void *fdsa_segmentedVector_segment(
+        fdsa_segmentedVector *vector,
+        size_t segment,
+        size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
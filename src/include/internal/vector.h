@@ -34,10 +34,112 @@ extern "C"
 
 typedef struct fdsa_vector fdsa_vector;
 
+/**
+ * @struct fdsa_vectorIndex
+ * A search index built once over a sorted fdsa_vector.
+ * It keeps its own copy of the elements in Eytzinger (BFS) order,
+ * so later changes of the vector are not seen by the index.
+ */
+typedef struct fdsa_vectorIndex fdsa_vectorIndex;
+
+/**
+ * @typedef fdsa_vector_visitFunc
+ * Called once per element by fdsa_vector_forEach.
+ */
+typedef void (*fdsa_vector_visitFunc)(const void *element, void *ctx);
+
+/**
+ * @typedef fdsa_vector_transformFunc
+ * Called once per element by fdsa_vector_transform,
+ * it may modify the element in place.
+ */
+typedef void (*fdsa_vector_transformFunc)(void *element, void *ctx);
+
+/**
+ * @typedef fdsa_vector_reduceFunc
+ * Folds rhs (an element or another accumulator) into the accumulator acc.
+ */
+typedef void (*fdsa_vector_reduceFunc)(void *acc, const void *rhs, void *ctx);
+
+/**
+ * @typedef fdsa_vector_predFunc
+ * Returns non-zero if fdsa_vector_removeIf should remove the element.
+ */
+typedef int (*fdsa_vector_predFunc)(const void *element, void *ctx);
+
+/**
+ * @typedef fdsa_vector_deallocFunc
+ * Releases a buffer passed to fdsa_vector_adopt or returned by
+ * fdsa_vector_takeBuffer.
+ * @param bytes capacity of the buffer in bytes, for munmap and pools
+ */
+typedef void (*fdsa_vector_deallocFunc)(void *ptr, size_t bytes, void *ctx);
+
+/**
+ * @enum fdsa_vector_cmpOp
+ * Key comparisons of fdsa_vector_removeIfKey, key op value.
+ */
+typedef enum fdsa_vector_cmpOp
+{
+    fdsa_vector_cmpLess = 1,
+    fdsa_vector_cmpEqual = 2,
+    fdsa_vector_cmpLessEqual = 3,
+    fdsa_vector_cmpGreater = 4,
+    fdsa_vector_cmpNotEqual = 5,
+    fdsa_vector_cmpGreaterEqual = 6
+} fdsa_vector_cmpOp;
+
+/**
+ * @enum fdsa_vector_flag
+ * Flags for fdsa_vector_createEx and fdsa_vector_openMapped.
+ */
+typedef enum fdsa_vector_flag
+{
+    fdsa_vector_lockMutex = 0x0, /**< exclusive mutex, the default */
+    fdsa_vector_lockNone = 0x1, /**< no locking, single owner only */
+    fdsa_vector_lockSpin = 0x2, /**< spinlock, for short critical sections */
+    fdsa_vector_lockShared = 0x3, /**< reader-writer lock, at, size,
+                                       capacity and data take shared
+                                       ownership */
+    fdsa_vector_lockMask = 0xf,
+
+    /**
+     * Keep the first 64 bytes of elements inside the vector object,
+     * the buffer moves to the heap only when it overflows.
+     * Ignored with an alignment larger than the malloc one.
+     */
+    fdsa_vector_inlineStorage = 0x10,
+
+    /**
+     * fdsa_vector_openMapped reads the whole file once
+     * and fails if the checksum does not match.
+     */
+    fdsa_vector_verifyChecksum = 0x20,
+
+    /**
+     * Buffers of 1 MiB and more are mapped in whole 2 MiB huge pages,
+     * aligned on a huge page and advised with MADV_HUGEPAGE, so large
+     * random-access vectors take fewer TLB misses. Linux only.
+     */
+    fdsa_vector_hugePages = 0x40,
+
+    /**
+     * Same as fdsa_vector_hugePages, but try the reserved MAP_HUGETLB
+     * pool first and fall back if it has no free pages.
+     */
+    fdsa_vector_hugeTLB = 0x80
+} fdsa_vector_flag;
+
 typedef struct fdsa_vector_api
 {
     fdsa_vector *(*create)(size_t sizeOfData);
 
+    fdsa_vector *(*createEx)(size_t sizeOfData, unsigned flags);
+
+    fdsa_vector *(*createAligned)(size_t sizeOfData,
+                                  unsigned flags,
+                                  size_t alignment);
+
     fdsa_exitstate (*destory)(fdsa_vector *vector);
 
     fdsa_exitstate (*at)(fdsa_vector *vector, size_t index, void *dst);
@@ -46,6 +148,21 @@ typedef struct fdsa_vector_api
                                size_t index,
                                const void *src);
 
+    fdsa_exitstate (*atRange)(fdsa_vector *vector,
+                              size_t first,
+                              size_t count,
+                              void *dst);
+
+    fdsa_exitstate (*setRange)(fdsa_vector *vector,
+                               size_t first,
+                               size_t count,
+                               const void *src);
+
+    fdsa_exitstate (*fill)(fdsa_vector *vector,
+                           size_t first,
+                           size_t count,
+                           const void *src);
+
     fdsa_exitstate (*clear)(fdsa_vector *vector);
 
     fdsa_exitstate (*size)(fdsa_vector *vector, size_t *dst);
@@ -68,10 +185,139 @@ typedef struct fdsa_vector_api
 
     void *(*takeData)(fdsa_vector *vector);
 
+    fdsa_exitstate (*setGrowthPolicy)(fdsa_vector *vector,
+                                      double factor,
+                                      size_t minStep,
+                                      size_t maxStep);
+
+    fdsa_exitstate (*sort)(fdsa_vector *vector, fdsa_cmpFunc cmpFunc);
+
+    fdsa_exitstate (*radixSort)(fdsa_vector *vector,
+                                size_t keyOffset,
+                                size_t keySize,
+                                int isSigned);
+
+    fdsa_exitstate (*lowerBound)(fdsa_vector *vector,
+                                 const void *key,
+                                 fdsa_cmpFunc cmpFunc,
+                                 size_t *dst);
+
+    fdsa_exitstate (*upperBound)(fdsa_vector *vector,
+                                 const void *key,
+                                 fdsa_cmpFunc cmpFunc,
+                                 size_t *dst);
+
+    fdsa_exitstate (*equalRange)(fdsa_vector *vector,
+                                 const void *key,
+                                 fdsa_cmpFunc cmpFunc,
+                                 size_t *first,
+                                 size_t *last);
+
+    fdsa_vectorIndex *(*buildIndex)(fdsa_vector *vector,
+                                    fdsa_cmpFunc cmpFunc);
+
+    fdsa_exitstate (*destroyIndex)(fdsa_vectorIndex *index);
+
+    fdsa_exitstate (*indexLowerBound)(fdsa_vectorIndex *index,
+                                      const void *key,
+                                      size_t *dst);
+
+    fdsa_exitstate (*indexUpperBound)(fdsa_vectorIndex *index,
+                                      const void *key,
+                                      size_t *dst);
+
+    fdsa_exitstate (*forEach)(fdsa_vector *vector,
+                              fdsa_vector_visitFunc func,
+                              void *ctx);
+
+    fdsa_exitstate (*transform)(fdsa_vector *vector,
+                                fdsa_vector_transformFunc func,
+                                void *ctx);
+
+    fdsa_exitstate (*reduce)(fdsa_vector *vector,
+                             const void *init,
+                             size_t sizeOfAcc,
+                             fdsa_vector_reduceFunc accumulate,
+                             fdsa_vector_reduceFunc combine,
+                             void *ctx,
+                             void *dst);
+
+    fdsa_exitstate (*insertAt)(fdsa_vector *vector,
+                               size_t index,
+                               const void *src);
+
+    fdsa_exitstate (*insertRange)(fdsa_vector *vector,
+                                  size_t index,
+                                  const void *src,
+                                  size_t count);
+
+    fdsa_exitstate (*eraseAt)(fdsa_vector *vector, size_t index);
+
+    fdsa_exitstate (*eraseRange)(fdsa_vector *vector,
+                                 size_t first,
+                                 size_t count);
+
+    fdsa_exitstate (*removeIf)(fdsa_vector *vector,
+                               fdsa_vector_predFunc pred,
+                               void *ctx,
+                               size_t *removed);
+
+    fdsa_exitstate (*removeIfKey)(fdsa_vector *vector,
+                                  size_t keyOffset,
+                                  size_t keySize,
+                                  int isSigned,
+                                  fdsa_vector_cmpOp op,
+                                  const void *value,
+                                  size_t *removed);
+
+    fdsa_exitstate (*save)(fdsa_vector *vector, const char *path);
+
+    fdsa_vector *(*openMapped)(const char *path, unsigned flags);
+
+    fdsa_exitstate (*adopt)(fdsa_vector *vector,
+                            void *ptr,
+                            size_t size,
+                            size_t capacity,
+                            fdsa_vector_deallocFunc dealloc,
+                            void *ctx);
+
+    void *(*takeBuffer)(fdsa_vector *vector,
+                        size_t *size,
+                        size_t *capacity,
+                        fdsa_vector_deallocFunc *dealloc,
+                        void **ctx);
+
+    fdsa_exitstate (*reset)(fdsa_vector *vector);
+
+    fdsa_exitstate (*shrinkToFit)(fdsa_vector *vector);
+
+    fdsa_exitstate (*setTrimPolicy)(fdsa_vector *vector,
+                                    double threshold,
+                                    size_t minCapacity);
+
+    fdsa_vector *(*snapshot)(fdsa_vector *vector);
+
 } fdsa_vector_api;
 
 FDSA_API fdsa_vector *fdsa_vector_create(size_t sizeOfData);
 
+/**
+ * Create a vector with options.
+ * @param flags a combination of fdsa_vector_flag,
+ *        fdsa_vector_create(size) is fdsa_vector_createEx(size, 0)
+ */
+FDSA_API fdsa_vector *fdsa_vector_createEx(size_t sizeOfData, unsigned flags);
+
+/**
+ * Create a vector whose buffer is always aligned to alignment bytes,
+ * e.g. 64 for a cache line or 4096 for direct I/O. The alignment holds
+ * across every growth and for the buffer returned by takeData.
+ * @param alignment a power of two, 0 means the malloc alignment
+ */
+FDSA_API fdsa_vector *fdsa_vector_createAligned(size_t sizeOfData,
+                                                unsigned flags,
+                                                size_t alignment);
+
 FDSA_API fdsa_exitstate fdsa_vector_destroy(fdsa_vector *vector);
 
 FDSA_API fdsa_exitstate fdsa_vector_at(fdsa_vector *vector,
@@ -82,6 +328,30 @@ FDSA_API fdsa_exitstate fdsa_vector_setValue(fdsa_vector *vector,
                                              size_t index,
                                              const void *src);
 
+/**
+ * Copy elements [first, first + count) into dst under one lock.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_atRange(fdsa_vector *vector,
+                                            size_t first,
+                                            size_t count,
+                                            void *dst);
+
+/**
+ * Overwrite elements [first, first + count) from src under one lock.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_setRange(fdsa_vector *vector,
+                                             size_t first,
+                                             size_t count,
+                                             const void *src);
+
+/**
+ * Overwrite elements [first, first + count) with the element at src.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_fill(fdsa_vector *vector,
+                                         size_t first,
+                                         size_t count,
+                                         const void *src);
+
 FDSA_API fdsa_exitstate fdsa_vector_clear(fdsa_vector *vector);
 
 FDSA_API fdsa_exitstate fdsa_vector_size(fdsa_vector *vector, size_t *dst);
@@ -103,8 +373,271 @@ FDSA_API fdsa_exitstate fdsa_vector_append(fdsa_vector *vector,
 
 FDSA_API const void *fdsa_vector_data(fdsa_vector *vector);
 
+/**
+ * Take the ownership of the buffer, the vector becomes empty.
+ * A buffer that must be copied out (inline, mapped, adopted or shared)
+ * is copied by its size, so an empty one gives NULL.
+ * The returned buffer must be released with free(), or with
+ * _aligned_free() on Windows if the vector was created with an alignment
+ * larger than the malloc one.
+ */
 FDSA_API void *fdsa_vector_takeData(fdsa_vector *vector);
 
+/**
+ * Set how the vector grows when pushBack, append or resize run out of
+ * capacity. The new capacity is capacity * factor, but the step is clamped
+ * to [minStep, maxStep] and never smaller than the requested size.
+ * Default policy is factor = 2.0, minStep = 4, maxStep = 0.
+ * @param factor growth factor, must be >= 1.0
+ * @param minStep minimum number of elements added per growth, must be > 0
+ * @param maxStep maximum number of elements added per growth, 0 = unbounded
+ */
+FDSA_API fdsa_exitstate fdsa_vector_setGrowthPolicy(fdsa_vector *vector,
+                                                    double factor,
+                                                    size_t minStep,
+                                                    size_t maxStep);
+
+/**
+ * Sort the vector in place with cmpFunc. Large vectors are split into
+ * one run per hardware thread, the runs are sorted and then merged in
+ * parallel. cmpFunc must be safe to call from several threads.
+ * The environment variable FDSA_THREADS, a positive integer, caps the
+ * number of threads; it cannot exceed the hardware thread count.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_sort(fdsa_vector *vector,
+                                         fdsa_cmpFunc cmpFunc);
+
+/**
+ * Stable LSD radix sort on an integer key stored inside each element
+ * in native byte order.
+ * @param keyOffset byte offset of the key within the element
+ * @param keySize 1, 2, 4 or 8
+ * @param isSigned non-zero for two's complement keys
+ */
+FDSA_API fdsa_exitstate fdsa_vector_radixSort(fdsa_vector *vector,
+                                              size_t keyOffset,
+                                              size_t keySize,
+                                              int isSigned);
+
+/**
+ * Search a vector sorted by cmpFunc, cmpFunc is called as
+ * cmpFunc(element, key).
+ * @param dst index of the first element that is not less than key,
+ *        or size if there is none
+ */
+FDSA_API fdsa_exitstate fdsa_vector_lowerBound(fdsa_vector *vector,
+                                               const void *key,
+                                               fdsa_cmpFunc cmpFunc,
+                                               size_t *dst);
+
+/**
+ * @param dst index of the first element greater than key,
+ *        or size if there is none
+ */
+FDSA_API fdsa_exitstate fdsa_vector_upperBound(fdsa_vector *vector,
+                                               const void *key,
+                                               fdsa_cmpFunc cmpFunc,
+                                               size_t *dst);
+
+/**
+ * The elements equal to key are [first, last).
+ */
+FDSA_API fdsa_exitstate fdsa_vector_equalRange(fdsa_vector *vector,
+                                               const void *key,
+                                               fdsa_cmpFunc cmpFunc,
+                                               size_t *first,
+                                               size_t *last);
+
+/**
+ * Build an Eytzinger-layout index over a vector sorted by cmpFunc.
+ * Repeated searches through the index touch far fewer cache lines.
+ */
+FDSA_API fdsa_vectorIndex *fdsa_vector_buildIndex(fdsa_vector *vector,
+                                                  fdsa_cmpFunc cmpFunc);
+
+FDSA_API fdsa_exitstate fdsa_vector_destroyIndex(fdsa_vectorIndex *index);
+
+/**
+ * Same result as fdsa_vector_lowerBound on the vector the index was
+ * built from.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_indexLowerBound(fdsa_vectorIndex *index,
+                                                    const void *key,
+                                                    size_t *dst);
+
+/**
+ * Same result as fdsa_vector_upperBound on the vector the index was
+ * built from.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_indexUpperBound(fdsa_vectorIndex *index,
+                                                    const void *key,
+                                                    size_t *dst);
+
+/**
+ * Call func on every element. The elements are split into chunks that run
+ * on several threads, so func must be thread safe and must not call back
+ * into the vector. The visiting order is unspecified.
+ * FDSA_THREADS limits the threads as for fdsa_vector_sort, and also
+ * applies to transform and reduce.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_forEach(fdsa_vector *vector,
+                                            fdsa_vector_visitFunc func,
+                                            void *ctx);
+
+/**
+ * Same as fdsa_vector_forEach, but func may modify the elements.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_transform(fdsa_vector *vector,
+                                              fdsa_vector_transformFunc func,
+                                              void *ctx);
+
+/**
+ * Every chunk starts from a copy of init and accumulates its elements
+ * in order, then the chunk results are combined from left to right.
+ * The chunking only depends on the element size, so the result is the
+ * same for any number of threads.
+ * @param init identity value of the reduction, sizeOfAcc bytes
+ * @param dst receives the result, sizeOfAcc bytes
+ */
+FDSA_API fdsa_exitstate fdsa_vector_reduce(fdsa_vector *vector,
+                                           const void *init,
+                                           size_t sizeOfAcc,
+                                           fdsa_vector_reduceFunc accumulate,
+                                           fdsa_vector_reduceFunc combine,
+                                           void *ctx,
+                                           void *dst);
+
+/**
+ * Insert an element before index, index may be equal to the size.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_insertAt(fdsa_vector *vector,
+                                             size_t index,
+                                             const void *src);
+
+/**
+ * Insert count elements from src before index.
+ * src must not point into the vector.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_insertRange(fdsa_vector *vector,
+                                                size_t index,
+                                                const void *src,
+                                                size_t count);
+
+FDSA_API fdsa_exitstate fdsa_vector_eraseAt(fdsa_vector *vector,
+                                            size_t index);
+
+/**
+ * Remove the elements [first, first + count), later elements move down.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_eraseRange(fdsa_vector *vector,
+                                               size_t first,
+                                               size_t count);
+
+/**
+ * Remove every element for which pred returns non-zero in one pass,
+ * the kept elements keep their order.
+ * @param removed receives the number of removed elements, may be NULL
+ */
+FDSA_API fdsa_exitstate fdsa_vector_removeIf(fdsa_vector *vector,
+                                             fdsa_vector_predFunc pred,
+                                             void *ctx,
+                                             size_t *removed);
+
+/**
+ * Remove every element whose integer key compares to value by op,
+ * without a callback per element.
+ * @param keySize 1, 2, 4 or 8 bytes, the key is in native byte order
+ * @param value points to a key of keySize bytes
+ * @param removed receives the number of removed elements, may be NULL
+ */
+FDSA_API fdsa_exitstate fdsa_vector_removeIfKey(fdsa_vector *vector,
+                                                size_t keyOffset,
+                                                size_t keySize,
+                                                int isSigned,
+                                                fdsa_vector_cmpOp op,
+                                                const void *value,
+                                                size_t *removed);
+
+/**
+ * Write the vector to path: a 64-byte header with the element size,
+ * count, alignment and a checksum, then the raw elements.
+ * The file uses the native byte order.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_save(fdsa_vector *vector,
+                                         const char *path);
+
+/**
+ * Open a file written by fdsa_vector_save without copying it.
+ * The elements point into a read-only shared mapping of the file,
+ * so every function that modifies the vector fails on it.
+ * Release it with fdsa_vector_destroy.
+ * @param flags a lock policy, optionally with fdsa_vector_verifyChecksum
+ */
+FDSA_API fdsa_vector *fdsa_vector_openMapped(const char *path,
+                                             unsigned flags);
+
+/**
+ * Take the ownership of ptr without copying, the old buffer is released.
+ * dealloc(ptr, capacity * sizeOfData, ctx) is called when the vector
+ * lets the buffer go: on destroy, reset or when growth moves the elements
+ * to a new buffer.
+ * @param ptr must meet the alignment the vector was created with
+ * @param size elements already in ptr
+ * @param capacity elements ptr can hold
+ */
+FDSA_API fdsa_exitstate fdsa_vector_adopt(fdsa_vector *vector,
+                                          void *ptr,
+                                          size_t size,
+                                          size_t capacity,
+                                          fdsa_vector_deallocFunc dealloc,
+                                          void *ctx);
+
+/**
+ * Inverse of fdsa_vector_adopt, the vector becomes empty.
+ * The buffer is handed over as is unless it is inline storage,
+ * release it with dealloc(buffer, capacity * sizeOfData, ctx).
+ * Returns NULL if the vector has no elements and no buffer.
+ */
+FDSA_API void *fdsa_vector_takeBuffer(fdsa_vector *vector,
+                                      size_t *size,
+                                      size_t *capacity,
+                                      fdsa_vector_deallocFunc *dealloc,
+                                      void **ctx);
+
+/**
+ * Remove every element and release the buffer.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_reset(fdsa_vector *vector);
+
+/**
+ * Reduce the capacity to the size, releasing the buffer if it is empty.
+ */
+FDSA_API fdsa_exitstate fdsa_vector_shrinkToFit(fdsa_vector *vector);
+
+/**
+ * Release memory automatically. Whenever clear, resize, erase or removeIf
+ * leave size * threshold below the capacity, the capacity shrinks to
+ * twice the size, but not below minCapacity. The policy is off by default.
+ * @param threshold 0 turns the policy off, otherwise it must be > 2.0
+ * @param minCapacity the policy never shrinks below this many elements
+ */
+FDSA_API fdsa_exitstate fdsa_vector_setTrimPolicy(fdsa_vector *vector,
+                                                  double threshold,
+                                                  size_t minCapacity);
+
+/**
+ * Take a read-only view of the current elements in O(1).
+ * The snapshot shares the buffer with the vector. Appends that fit in the
+ * capacity copy nothing. The first write to an element a live snapshot
+ * can see, or a move of the buffer, copies the whole buffer under the
+ * vector's lock, since both sides keep one contiguous buffer: release
+ * snapshots before writing to avoid that copy, the vector then takes the
+ * buffer back as is.
+ * Snapshots take no lock, every function that modifies them fails.
+ * Release it with fdsa_vector_destroy, in any order with the vector.
+ */
+FDSA_API fdsa_vector *fdsa_vector_snapshot(fdsa_vector *vector);
+
 #ifdef __cplusplus
 }
 #endif